@@ -1,51 +1,107 @@
 #include <iostream>
 #include <cassert>
+#include <cstring>
+#include <thread>
 
 
-#include "albatross.hpp"
+#include "job.hpp"
+#include "server.hpp"
+#include "batch.hpp"
 
 
+static void usage (const char *name) {
+    std::cerr << "Usage: " << name << " " << Albatross::job_usage() << std::endl;
+    std::cerr << "       " << name << " --serve|--serve-socket PATH"
+        << " [--workers N] [options]" << std::endl;
+    std::cerr << "       " << name << " --batch LIST [--workers N]"
+        << " [--memory-limit MB] [options]" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
 int main (int argc, char **argv) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " dimacs.cnf" << std::endl;
-        exit(EXIT_FAILURE);
-    }
-    FILE* in = fopen(argv[1], "rb");
-    if (in == NULL) {
-        std::cerr << "ERROR: Could not open: " << argv[1] << std::endl;
-        exit(EXIT_FAILURE);
+    std::vector<std::string> args;
+    bool serve = false;
+    const char *socket_path = NULL;
+    const char *batch_path = NULL;
+    long memory_limit = 0;
+    int  nof_workers = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--serve") == 0)
+            serve = true;
+        else if (strcmp(argv[i], "--serve-socket") == 0 && i+1 < argc)
+            socket_path = argv[++i];
+        else if (strcmp(argv[i], "--batch") == 0 && i+1 < argc)
+            batch_path = argv[++i];
+        else if (strcmp(argv[i], "--memory-limit") == 0 && i+1 < argc) {
+            memory_limit = atol(argv[++i]);
+            if (memory_limit < 1)
+                usage(argv[0]);
+        }
+        else if (strcmp(argv[i], "--workers") == 0 && i+1 < argc) {
+            nof_workers = atoi(argv[++i]);
+            if (nof_workers < 1)
+                usage(argv[0]);
+        }
+        else
+            args.push_back(argv[i]);
     }
+    Albatross::Job job;
+    if (!Albatross::parse_job(args, job))
+        usage(argv[0]);
 
-    Albatross::Solver solver;
-    solver.read_dimacs(in);
-    fclose(in);
-
-    int res;
-    int y = solver.ovars[0];
-    std::vector<int> model, clause;
-
-    while (true) {
-        res = solver.solve();
-        if (res == CaDiCaL::UNSATISFIABLE) {
-            std::cout << "s UNSATISFIABLE" << std::endl;
-            break;
+    if (batch_path != NULL) {
+        // a CNF file on each line of the list.
+        if (job.path != "-" || serve || socket_path != NULL)
+            usage(argv[0]);
+        std::vector<std::string> paths;
+        const bool from_stdin = strcmp(batch_path, "-") == 0;
+        FILE *list = from_stdin? stdin: fopen(batch_path, "r");
+        if (list == NULL) {
+            std::cerr << "ERROR: Could not open: " << batch_path << std::endl;
+            return EXIT_FAILURE;
         }
-        solver.read_model(model);
-        if (model[y] == 1) {
-            std::cout << "s SATISFIABLE" << std::endl;
-            solver.print_model(std::cout, model);
-            break;
+        char *line = NULL;
+        size_t cap = 0;
+        ssize_t len;
+        while ((len = getline(&line, &cap, list)) >= 0) {
+            while (len > 0 && isspace((unsigned char)line[len-1]))
+                len--;
+            if (len > 0)
+                paths.push_back(std::string(line, len));
         }
-        solver.print_assignment(std::cout, model);
-        solver.derive(clause, model);
-        solver.print_derived(std::cout, clause);
-        if (clause.size() == 0) {
-            std::cout << "s UNSATISFIABLE" << std::endl;
-            break;
+        free(line);
+        if (!from_stdin)
+            fclose(list);
+        Albatross::Writer out(stdout);
+        const int errors = Albatross::run_batch(job, paths, nof_workers,
+            memory_limit, out);
+        return errors == 0? 0: EXIT_FAILURE;
+    }
+    if (memory_limit > 0)
+        usage(argv[0]);
+
+    if (serve || socket_path != NULL) {
+        // the options given here are the defaults of each job.
+        if (job.path != "-")
+            usage(argv[0]);
+        Albatross::Server server(job, nof_workers);
+        if (socket_path == NULL)
+            server.serve_stdin();
+        else if (!server.serve_socket(socket_path)) {
+            std::cerr << "ERROR: Could not listen on: " << socket_path << std::endl;
+            return EXIT_FAILURE;
         }
-        solver.clause(clause);
+        return 0;
     }
 
-    solver.print_elapsed (std::cout);
+    Albatross::Writer out(stdout);
+    if (job.async_output)
+        out.start_thread();
+    std::string message;
+    if (!Albatross::run_job(job, NULL, out, message)) {
+        // returns to flush the output so far.
+        std::cerr << "ERROR: " << message << std::endl;
+        return EXIT_FAILURE;
+    }
     return 0;
 }
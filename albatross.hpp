@@ -7,10 +7,16 @@
 #include <set>
 #include <map>
 #include <string>
+#include <stdexcept>
 #include <chrono>
+#include <cstdio>
+#include <sys/types.h>
 
 #include "src/cadical.hpp"
 #include "upderiver.h"
+#include "writer.hpp"
+#include "stats.hpp"
+#include "filter.hpp"
 
 namespace Albatross {
 
@@ -19,41 +25,197 @@ static inline int lit_sign (int lit) {return lit < 0? 1: 0;}
 static inline int lit_var  (int lit) {return std::abs(lit);}
 static inline int toLit    (int idx) {return idx;}
 
+// error codes of Engine, also carried by the exceptions thrown while
+// loading and solving.
+enum ErrorCode {
+    ERROR_NONE,
+    ERROR_IO,         // could not open, read, decompress or write a file
+    ERROR_PARSE,      // malformed CNF or snapshot
+    ERROR_NO_OUTPUT,  // no output variable declared
+    ERROR_DERIVER,    // rejected by the deriver, which printed why
+    ERROR_STATE,      // called in the wrong state, e.g. after an error
+    ERROR_STOPPED,    // loading stopped by interrupt() or a deadline
+};
+
+class Error : public std::runtime_error {
+public:
+    ErrorCode code;
+    Error (ErrorCode c, const std::string& what)
+        : std::runtime_error (what), code (c) {}
+};
+
+// output levels: only the result, also statistics at the end, or also
+// the witness assignment and derived clauses of each iteration.
+enum Verbosity {
+    VERBOSITY_QUIET,
+    VERBOSITY_SUMMARY,
+    VERBOSITY_TRACE,
+};
+
 class Solver : public CaDiCaL::Solver {
     upderiver* deriver;
     std::chrono::system_clock::time_point start_clock;
+    long long last_derived, last_removed;
+    bool defer_ovars;
+    int  load_threads;
+    bool keep_clauses;
+    std::vector<int> clause_stream; // clauses given to CaDiCaL, if kept
+    std::vector<bool> ovar_mark;
+    int max_var;  // largest tagged variable
+    CaDiCaL::Terminator* load_terminator;  // NULL unless loading can stop
+    Stats* stats;  // NULL unless statistics are kept
+    ClauseFilter* filter;  // NULL unless derived clauses are filtered
 
 public:
     std::vector<int> ivars;
     std::vector<int> ovars;
     std::vector<int> wvars;
-    std::map<int,std::string>  names;
 
     Solver () {
         start_clock = std::chrono::system_clock::now();
+        last_derived = last_removed = 0;
+        defer_ovars = false;
+        load_threads = 1;
+        keep_clauses = false;
+        stats = NULL;
+        filter = NULL;
+        max_var = 0;
+        load_terminator = NULL;
         deriver = upderiver_new();
-        upderiver_addfunc(deriver,
-            Albatross::lit_neg,
-            Albatross::lit_sign,
-            Albatross::lit_var,
-            Albatross::toLit);
+        upderiver_usedimacs(deriver);
+#ifndef PRINT_BY_NAME
+        upderiver_setkeepnames(deriver, false);
+#endif
     }
 
     virtual ~Solver () {
         upderiver_delete(deriver);
     }
 
+    void set_minimize (bool minimize) {
+        upderiver_setminimize(deriver, minimize);
+    }
+
+    // accepts OVAR declarations anywhere in the input by routing clauses
+    // to the deriver after the whole input is read.
+    void set_defer_ovars (bool defer) {
+        defer_ovars = defer;
+    }
+
+    // tokenises the input on this many threads while loading.
+    void set_load_threads (int n) {
+        load_threads = n;
+    }
+
+    // keeps the clauses read so that save_snapshot() can write them.
+    void set_keep_clauses (bool keep) {
+        keep_clauses = keep;
+    }
+
+    // keeps variable names, which are only printed with PRINT_BY_NAME.
+    void set_keep_names (bool keep) {
+        upderiver_setkeepnames(deriver, keep);
+    }
+
+    // times the phases of the run and counts conflicts in s.
+    void set_stats (Stats* s) {
+        if (stats != NULL)
+            disconnect_learner();
+        stats = s;
+        if (stats != NULL)
+            connect_learner(stats);
+    }
+
+    // drops derived clauses rejected by f from the results of derive().
+    void set_filter (ClauseFilter* f) {
+        filter = f;
+    }
+
+    // polls t now and then while loading, which stops with ERROR_STOPPED
+    // once it returns true.
+    void set_load_terminator (CaDiCaL::Terminator* t) {
+        load_terminator = t;
+    }
+
+    void check_load_stopped (void) {
+        if (load_terminator != NULL && load_terminator->terminate())
+            throw Error(ERROR_STOPPED, "Stopped while loading.");
+    }
+
+    const upderiver_stats* deriver_stats (void) {
+        return upderiver_getstats(deriver);
+    }
+
+    // returns the name of idx, or NULL if it has none or names are not kept.
+    const char* name (int idx) {
+        return upderiver_getname(deriver, idx);
+    }
+
+    bool is_ovar (int idx) const {
+        return idx < ovar_mark.size() && ovar_mark[idx];
+    }
+
     void read_dimacs(FILE *file);
+    void read_dimacs(const char *data, size_t size);
+    bool read_snapshot (FILE *file);
+    bool read_snapshot (const char *data, size_t size);
+    void save_snapshot (const char *path);
     void set_variable (int idx, upderiver_var_tag tag, char name[], int n);
+    void tag_variable (int idx, upderiver_var_tag tag);
+    void add_clause (std::vector<int>& clause);
     void add_clause_to_deriver (std::vector<int>& clause);
     void read_model (std::vector<int>& model);
-    void derive (std::vector<int>& clause, std::vector<int>& model);
+    void read_projected_model (std::vector<int>& model);
+    void derive (std::vector<int>& clauses, std::vector<int>& sizes,
+        std::vector<int>& falsified, std::vector<int>& model);
+
+    void print_name (Writer& out, int idx);
+    void print_elapsed (Writer& out);
+    void print_minimized (Writer& out);
+    void print_minimized_total (Writer& out);
+    void print_derived (Writer& out, const std::vector<int>& clause);
+    void print_model (Writer& out, const std::vector<int>& model);
+    void print_assignment (Writer& out, const std::vector<int>& assign);
+};
+
+// opens path for reading, through a decompressor process if the file starts
+// with the magic bytes of gzip, bzip2 or xz, or stdin if path is "-".
+// returns NULL on failure.
+FILE* open_input (const char *path, pid_t& decompressor);
+void  close_input (FILE *file, pid_t decompressor, const char *path);
+
+// receives each model falsifying an output variable, and the clauses
+// derived from it, one after another in clauses with their sizes in sizes.
+class Listener {
+public:
+    virtual ~Listener () {}
+    virtual void model (const std::vector<int>& model) {}
+    virtual void derived (const std::vector<int>& clauses,
+        const std::vector<int>& sizes) {}
+};
+
+// derives blocking clauses from inside CaDiCaL whenever it finds a full
+// assignment, so that a whole run happens in a single solve() call.
+class Propagator : public CaDiCaL::ExternalPropagator {
+    Solver* solver;
+    Listener* listener;
+    std::vector<int> model, falsified, clauses, sizes;
+    int next_clause, next_pos, next_lit;
+
+public:
+    int  iterations;
+    bool derived_empty;
+
+    Propagator (Solver* s, Listener* l);
+
+    int solve (const std::vector<int>& assumptions);
 
-    void print_elapsed (std::ostream& out);
-    void print_derived (std::ostream& out, const std::vector<int>& clause);
-    void print_model (std::ostream& out, const std::vector<int>& model);
-    void print_assignment
-        (std::ostream& out, const std::vector<int>& assign);
+    void notify_assignment (const std::vector<int>& lits) {}
+    void notify_new_decision_level () {}
+    void notify_backtrack (size_t new_level) {}
+    bool cb_check_found_model (const std::vector<int>& lits);
+    bool cb_has_external_clause (bool& is_forgettable);
+    int  cb_add_external_clause_lit ();
 };
 
 }
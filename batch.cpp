@@ -0,0 +1,196 @@
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <malloc.h>
+
+#include "batch.hpp"
+
+namespace Albatross {
+
+
+struct BatchResult {
+    const char* status = "-";
+    long long   iterations = 0;
+    double      seconds = 0;
+    std::string message;  // of an error
+};
+
+// a running job, watched by the memory monitor until its engine is freed.
+struct Running {
+    Engine* engine;  // NULL once freed
+    off_t   size;
+    bool    memout;
+};
+
+// resident set size of the process in MB, or -1 if unknown.
+static long resident_mb (void)
+{
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f == NULL)
+        return -1;
+    long pages, resident;
+    const bool ok = fscanf(f, "%ld %ld", &pages, &resident) == 2;
+    fclose(f);
+    return ok? resident * (sysconf(_SC_PAGESIZE) / 1024) / 1024: -1;
+}
+
+int run_batch (const Job& job, const std::vector<std::string>& paths,
+    int nof_workers, long memory_limit, Writer& out)
+{
+    const int n = paths.size();
+    std::vector<off_t> sizes(n, 0);
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++) {
+        struct stat st;
+        if (stat(paths[i].c_str(), &st) == 0)
+            sizes[i] = st.st_size;
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [&sizes] (int a, int b) {return sizes[a] > sizes[b];});
+
+    std::vector<BatchResult> results(n);
+    std::atomic<int> next (0);
+    std::mutex mutex;
+    std::vector<Running*> running;
+    bool done = false;
+    std::condition_variable cond;
+
+    auto work = [&] (void) {
+        while (true) {
+            const int k = next++;
+            if (k >= n)
+                return;
+            const int i = order[k];
+            BatchResult& r = results[i];
+            const double begin = Stats::now();
+            Running run = {NULL, sizes[i], false};
+            Result result;
+            result.status = 0;
+            result.iterations = 0;
+            StopReason stop = STOP_NONE;
+            {
+                // the time limit of a job includes loading.
+                Options options = job.options;
+                options.time_limit = 0;
+                Engine engine(options);
+                engine.set_deadline(job.options.time_limit);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    run.engine = &engine;
+                    running.push_back(&run);
+                }
+                result.error = engine.load(paths[i].c_str());
+                if (result.error != ERROR_NONE)
+                    result.message = engine.error_message();
+                else
+                    result = engine.solve();
+                stop = engine.stop_reason();
+                std::lock_guard<std::mutex> lock(mutex);
+                run.engine = NULL;
+            }
+            r.seconds = Stats::now() - begin;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running.erase(std::find(running.begin(), running.end(), &run));
+            }
+            if (run.memout)
+                malloc_trim(0);  // lets the monitor see the memory freed
+            r.iterations = result.iterations;
+            if (result.error != ERROR_NONE && result.error != ERROR_STOPPED) {
+                r.status = "ERROR";
+                r.message = result.message;
+            } else if (result.status == Engine::SATISFIABLE)
+                r.status = "SATISFIABLE";
+            else if (result.status == Engine::UNSATISFIABLE)
+                r.status = "UNSATISFIABLE";
+            else if (stop == STOP_INTERRUPT && run.memout)
+                r.status = "MEMOUT";
+            else if (stop == STOP_TIME_LIMIT)
+                r.status = "TIMEOUT";
+            else
+                r.status = "UNKNOWN";
+        }
+    };
+
+    // stops the largest running job while over the limit. the next one is
+    // only stopped once the memory of the last one is freed.
+    auto monitor = [&] (void) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!done) {
+            cond.wait_for(lock, std::chrono::milliseconds(100));
+            const long rss = resident_mb();
+            if (rss < 0 || running.empty()
+                || rss <= memory_limit * (long)running.size())
+                continue;
+            Running* largest = NULL;
+            bool stopping = false;
+            for (auto i = running.begin(); i != running.end(); i++) {
+                if ((*i)->memout)
+                    stopping = true;
+                else if ((*i)->engine != NULL
+                    && (largest == NULL || (*i)->size > largest->size))
+                    largest = *i;
+            }
+            if (!stopping && largest != NULL) {
+                largest->memout = true;
+                largest->engine->interrupt();
+            }
+        }
+    };
+
+    const double begin = Stats::now();
+    std::thread watcher;
+    if (memory_limit > 0)
+        watcher = std::thread(monitor);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < std::min(nof_workers, n); i++)
+        workers.push_back(std::thread(work));
+    for (auto i = workers.begin(); i != workers.end(); i++)
+        i->join();
+    if (memory_limit > 0) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        cond.notify_all();
+        watcher.join();
+    }
+
+    size_t width = 4;
+    for (auto i = paths.begin(); i != paths.end(); i++)
+        width = std::max(width, i->size());
+    char line[64];
+    out << "file" << std::string(width-4, ' ');
+    snprintf(line, sizeof(line), " %-13s %12s %10s\n",
+        "status", "iterations", "time(s)");
+    out << line;
+    int solved = 0, errors = 0;
+    for (int i = 0; i < n; i++) {
+        const BatchResult& r = results[i];
+        out << paths[i] << std::string(width - paths[i].size(), ' ');
+        snprintf(line, sizeof(line), " %-13s %12lld %10.3f\n",
+            r.status, r.iterations, r.seconds);
+        out << line;
+        if (strcmp(r.status, "SATISFIABLE") == 0
+            || strcmp(r.status, "UNSATISFIABLE") == 0)
+            solved++;
+        if (strcmp(r.status, "ERROR") == 0) {
+            out << "  " << r.message << '\n';
+            errors++;
+        }
+    }
+    out << "c batch: solved " << solved << " of " << n
+        << " in " << Stats::now() - begin << " s on " << (long long)workers.size()
+        << " threads\n";
+    return errors;
+}
+
+}
@@ -0,0 +1,24 @@
+#ifndef albatross_batch_h
+#define albatross_batch_h
+
+#include <string>
+#include <vector>
+
+#include "job.hpp"
+
+namespace Albatross {
+
+// solves each of paths with the options of job on nof_workers threads,
+// largest file first, and prints a table of the results in the order of
+// paths. a job stops with TIMEOUT job.options.time_limit seconds after it
+// starts, including loading.
+// with memory_limit MB, the largest running job stops with MEMOUT while
+// the process uses more than memory_limit MB for each running job. the
+// process is shared by all jobs, so this limit is approximate.
+// returns the number of jobs ending with an error.
+int run_batch (const Job& job, const std::vector<std::string>& paths,
+    int nof_workers, long memory_limit, Writer& out);
+
+}
+
+#endif
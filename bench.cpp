@@ -0,0 +1,210 @@
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+
+#include "upderiver.h"
+
+// measures the deriver on a synthetic complementary-encoded formula: each
+// gate is an AND of random earlier signals (witness variables or gates)
+// encoded by clauses including the output variable y, and each input
+// variable is equivalent to a random signal. under ~y, any assignment to
+// the witness variables propagates to every gate and input variable
+// without conflict. with --batch, models are derived upderiver_batch_lanes
+// at a time by upderiver_derive_batch(), and each latency is of a batch.
+
+struct Params {
+    int  inputs    = 1000;
+    int  witnesses = 1000;
+    int  gates     = 100000;
+    int  fanin     = 3;
+    int  models    = 1000;
+    int  flips     = 0; // witness variables changed between models, 0: all random
+    int  seed      = 1;
+    bool minimize  = false;
+    bool batch     = false;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double seconds (Clock::time_point begin, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+static void usage (const char *name)
+{
+    std::cerr << "Usage: " << name << " [--inputs N] [--witnesses N]"
+        << " [--gates N] [--fanin K] [--models N] [--flips K] [--seed S]"
+        << " [--minimize] [--batch]" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+// variables: witnesses 1..W, gates W+1..W+G, inputs W+G+1..W+G+I, y.
+static void generate (const Params& p, std::mt19937& rng,
+    std::vector<int>& clauses, int y)
+{
+    const int W = p.witnesses;
+    std::vector<int> lits;
+    for (int g = W+1; g <= W+p.gates; g++) {
+        lits.clear();
+        for (int k = 0; k < p.fanin; k++) {
+            const int v = std::uniform_int_distribution<int>(1, g-1)(rng);
+            lits.push_back(rng() & 1? v: -v);
+        }
+        // g -> l_k
+        for (int k = 0; k < p.fanin; k++) {
+            clauses.push_back(y);
+            clauses.push_back(-g);
+            clauses.push_back(lits[k]);
+            clauses.push_back(0);
+        }
+        // l_1 & ... & l_k -> g
+        clauses.push_back(y);
+        clauses.push_back(g);
+        for (int k = 0; k < p.fanin; k++)
+            clauses.push_back(-lits[k]);
+        clauses.push_back(0);
+    }
+    for (int x = W+p.gates+1; x < y; x++) {
+        const int v = std::uniform_int_distribution<int>(1, W+p.gates)(rng);
+        const int s = rng() & 1? v: -v;
+        const int eq[] = {y, -x, s, 0, y, x, -s, 0};
+        clauses.insert(clauses.end(), eq, eq+8);
+    }
+}
+
+int main (int argc, char **argv)
+{
+    Params p;
+    for (int i = 1; i < argc; i++) {
+        int *arg = NULL;
+        if (strcmp(argv[i], "--inputs") == 0)
+            arg = &p.inputs;
+        else if (strcmp(argv[i], "--witnesses") == 0)
+            arg = &p.witnesses;
+        else if (strcmp(argv[i], "--gates") == 0)
+            arg = &p.gates;
+        else if (strcmp(argv[i], "--fanin") == 0)
+            arg = &p.fanin;
+        else if (strcmp(argv[i], "--models") == 0)
+            arg = &p.models;
+        else if (strcmp(argv[i], "--flips") == 0)
+            arg = &p.flips;
+        else if (strcmp(argv[i], "--seed") == 0)
+            arg = &p.seed;
+        else if (strcmp(argv[i], "--minimize") == 0)
+            p.minimize = true;
+        else if (strcmp(argv[i], "--batch") == 0)
+            p.batch = true;
+        else
+            usage(argv[0]);
+        if (arg != NULL) {
+            if (i+1 >= argc)
+                usage(argv[0]);
+            *arg = atoi(argv[++i]);
+        }
+    }
+    if (p.inputs < 1 || p.witnesses < 1 || p.gates < 0 || p.fanin < 1
+        || p.models < 1 || p.flips < 0 || (p.batch && p.minimize))
+        usage(argv[0]);
+
+    std::mt19937 rng(p.seed);
+    const int y = p.witnesses + p.gates + p.inputs + 1;
+    std::vector<int> clauses;
+    generate(p, rng, clauses, y);
+
+    // import
+    char name[] = "v";
+    const Clock::time_point import_begin = Clock::now();
+    upderiver *deriver = upderiver_new();
+    upderiver_usedimacs(deriver);
+    upderiver_setkeepnames(deriver, false);
+    upderiver_setminimize(deriver, p.minimize);
+    for (int v = 1; v <= p.witnesses; v++)
+        upderiver_setvar(deriver, v, CECD_WVAR, name, sizeof(name));
+    for (int v = p.witnesses+p.gates+1; v < y; v++)
+        upderiver_setvar(deriver, v, CECD_IVAR, name, sizeof(name));
+    upderiver_setvar(deriver, y, CECD_OVAR, name, sizeof(name));
+    long long nof_clauses = 0;
+    for (auto i = clauses.begin(); i != clauses.end(); ) {
+        auto j = std::find(i, clauses.end(), 0);
+        upderiver_addclause(deriver, &*i, &*j);
+        nof_clauses++;
+        i = j+1;
+    }
+    const double import_time = seconds(import_begin, Clock::now());
+
+    // derive
+    const int lanes = p.batch? upderiver_batch_lanes: 1;
+    std::vector<std::vector<int> > models(lanes, std::vector<int>(y+1, -1));
+    std::vector<int*> model_ptrs(lanes);
+    std::vector<int> clauses_out(lanes*p.inputs), sizes(lanes);
+    std::vector<double> latencies;
+    std::vector<int> model(y+1, -1);
+    for (int v = 1; v <= p.witnesses; v++)
+        model[v] = rng() & 1? 1: -1;
+    const long long propagations = upderiver_getstats(deriver)->propagations;
+    long long derived = 0;
+    double derive_time = 0;
+    for (int first = 0; first < p.models; first += lanes) {
+        const int n = std::min(lanes, p.models - first);
+        for (int k = 0; k < n; k++) {
+            if (p.flips == 0) {
+                for (int v = 1; v <= p.witnesses; v++)
+                    model[v] = rng() & 1? 1: -1;
+            } else {
+                for (int j = 0; j < p.flips; j++) {
+                    const int v = std::uniform_int_distribution<int>(1, p.witnesses)(rng);
+                    model[v] = -model[v];
+                }
+            }
+            std::copy(model.begin(), model.begin()+p.witnesses+1,
+                models[k].begin());
+            model_ptrs[k] = &models[k][0];
+        }
+        int ovar = y;
+        const Clock::time_point begin = Clock::now();
+        if (p.batch)
+            derived += upderiver_derive_batch(deriver, &clauses_out[0],
+                clauses_out.size(), &sizes[0], y, &model_ptrs[0], n, y+1);
+        else
+            derived += upderiver_derive(deriver, &clauses_out[0],
+                clauses_out.size(), NULL, &ovar, 1, &models[0][0], y+1);
+        const double t = seconds(begin, Clock::now());
+        latencies.push_back(t);
+        derive_time += t;
+    }
+    const long long nof_props =
+        upderiver_getstats(deriver)->propagations - propagations;
+    upderiver_delete(deriver);
+
+    std::sort(latencies.begin(), latencies.end());
+    const int n = latencies.size();
+    auto percentile = [&] (double q) {
+        return 1e6*latencies[std::min(n-1, (int)(q*n))];
+    };
+    printf("{\n");
+    printf("  \"params\": {\"inputs\": %d, \"witnesses\": %d, \"gates\": %d,"
+        " \"fanin\": %d, \"models\": %d, \"flips\": %d, \"seed\": %d,"
+        " \"minimize\": %s, \"batch\": %s},\n",
+        p.inputs, p.witnesses, p.gates, p.fanin, p.models, p.flips, p.seed,
+        p.minimize? "true": "false", p.batch? "true": "false");
+    printf("  \"addclause\": {\"clauses\": %lld, \"seconds\": %.6f,"
+        " \"clauses_per_sec\": %.1f},\n",
+        nof_clauses, import_time, nof_clauses/std::max(import_time, 1e-9));
+    printf("  \"propagate\": {\"propagations\": %lld, \"seconds\": %.6f,"
+        " \"propagations_per_sec\": %.1f},\n",
+        nof_props, derive_time, nof_props/std::max(derive_time, 1e-9));
+    printf("  \"derive\": {\"calls\": %d, \"models\": %d, \"literals\": %lld,"
+        " \"latency_us\": {\"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f,"
+        " \"p99\": %.3f, \"max\": %.3f, \"mean\": %.3f}}\n",
+        n, p.models, derived, 1e6*latencies[0], percentile(0.5), percentile(0.9),
+        percentile(0.99), 1e6*latencies[n-1], 1e6*derive_time/n);
+    printf("}\n");
+    return 0;
+}
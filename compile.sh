@@ -1,4 +1,18 @@
 #!/bin/bash
 
-#g++ -O3 -o albatross albatross.cpp parser.cpp solver.cpp upderiver.c -Lbuild/ -lcadical
-g++ -DNDEBUG -O3 -o albatross albatross.cpp parser.cpp solver.cpp upderiver.c -Lbuild/ -lcadical
+flags="-DNDEBUG -O3"
+#flags="-O3"
+lib="engine.cpp job.cpp server.cpp batch.cpp parser.cpp solver.cpp propagator.cpp snapshot.cpp writer.cpp stats.cpp filter.cpp upderiver.c"
+
+# libalbatross.a for embedding Albatross::Engine, see engine.hpp.
+objs=""
+for src in $lib; do
+    g++ $flags -c -o ${src%.*}.o $src || exit 1
+    objs="$objs ${src%.*}.o"
+done
+rm -f libalbatross.a
+ar rcs libalbatross.a $objs
+
+g++ $flags -o albatross albatross.cpp -L. -lalbatross -Lbuild/ -lcadical -pthread
+g++ -DNDEBUG -O3 -o albatross-bench bench.cpp upderiver.c
+g++ -DNDEBUG -O3 -o albatross-gen gen.cpp writer.cpp -pthread
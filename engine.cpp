@@ -0,0 +1,273 @@
+#include "engine.hpp"
+
+namespace Albatross {
+
+
+// the deriver has printed the message to stderr.
+static void throw_deriver_error (void)
+{
+    throw Error(ERROR_DERIVER, "Deriver error.");
+}
+
+Engine::Engine (const Options& o)
+        : options (o), stats (NULL),
+          loaded (false), failed (false), derived_empty (false),
+          interrupted (false), deadline (0), end_time (0), stopped (STOP_NONE),
+          iterations (0), propagator (NULL)
+{
+    // the hook is shared by all derivers, so it is set only once.
+    static const bool hooked =
+        (upderiver_seterrorhook(throw_deriver_error), true);
+    (void)hooked;
+
+    solver = new Solver();
+    solver->set_minimize(options.minimize);
+    solver->set_defer_ovars(options.defer_ovars);
+    solver->set_load_threads(options.load_threads);
+    solver->set_keep_clauses(options.keep_clauses);
+    if (options.keep_names)
+        solver->set_keep_names(true);
+    if (options.filter)
+        solver->set_filter(&filter);
+    solver->set_load_terminator(this);
+}
+
+Engine::~Engine ()
+{
+    delete solver;
+}
+
+ErrorCode Engine::fail (const Error& e)
+{
+    failed = true;
+    message = e.what();
+    return e.code;
+}
+
+bool Engine::stop (StopReason reason)
+{
+    stopped = reason;
+    return true;
+}
+
+// polled by CaDiCaL while solving, between iterations, and while loading.
+bool Engine::terminate ()
+{
+    if (interrupted)
+        return stop(STOP_INTERRUPT);
+    if (options.max_iterations > 0) {
+        const long long n = propagator != NULL? propagator->iterations: iterations;
+        if (n >= options.max_iterations)
+            return stop(STOP_ITERATION_LIMIT);
+    }
+    if (deadline > 0 || end_time > 0) {
+        const double now = Stats::now();
+        if ((deadline > 0 && now >= deadline) || (end_time > 0 && now >= end_time))
+            return stop(STOP_TIME_LIMIT);
+    }
+    return false;
+}
+
+void Engine::set_deadline (double seconds)
+{
+    end_time = seconds > 0? Stats::now() + seconds: 0;
+}
+
+void Engine::set_stats (Stats* s)
+{
+    stats = s;
+    solver->set_stats(s);
+}
+
+ErrorCode Engine::load (const char *path)
+{
+    if (loaded || failed) {
+        message = "A formula was already loaded.";
+        return ERROR_STATE;
+    }
+    pid_t decompressor;
+    FILE* in = open_input(path, decompressor);
+    if (in == NULL)
+        return fail(Error(ERROR_IO, std::string("Could not open: ") + path));
+    ErrorCode code = load(in);
+    try {
+        close_input(in, decompressor, path);
+    } catch (const Error& e) {
+        // a decompressor stopped early by an error also fails.
+        if (code == ERROR_NONE)
+            code = fail(e);
+    }
+    return code;
+}
+
+ErrorCode Engine::load (FILE *file)
+{
+    if (loaded || failed) {
+        message = "A formula was already loaded.";
+        return ERROR_STATE;
+    }
+    try {
+        solver->read_dimacs(file);
+        if (solver->ovars.empty())
+            throw Error(ERROR_NO_OUTPUT, "No output variable declared.");
+    } catch (const Error& e) {
+        return fail(e);
+    }
+    loaded = true;
+    return ERROR_NONE;
+}
+
+ErrorCode Engine::load (const char *data, size_t size)
+{
+    if (loaded || failed) {
+        message = "A formula was already loaded.";
+        return ERROR_STATE;
+    }
+    try {
+        solver->read_dimacs(data, size);
+        if (solver->ovars.empty())
+            throw Error(ERROR_NO_OUTPUT, "No output variable declared.");
+    } catch (const Error& e) {
+        return fail(e);
+    }
+    loaded = true;
+    return ERROR_NONE;
+}
+
+ErrorCode Engine::save_snapshot (const char *path)
+{
+    if (!loaded || failed) {
+        message = "No formula loaded.";
+        return ERROR_STATE;
+    }
+    try {
+        solver->save_snapshot(path);
+    } catch (const Error& e) {
+        message = e.what();
+        return e.code;
+    }
+    return ERROR_NONE;
+}
+
+Result Engine::solve (const std::vector<int>& assumptions, Listener* listener)
+{
+    Result result;
+    result.status = 0;
+    result.stop = STOP_NONE;
+    result.error = ERROR_NONE;
+    result.iterations = 0;
+    if (!loaded || failed) {
+        result.error = ERROR_STATE;
+        result.message = failed? "Failed by an earlier error.":
+            "No formula loaded.";
+        return result;
+    }
+    if (derived_empty) {
+        result.status = UNSATISFIABLE;
+        return result;
+    }
+
+    deadline = options.time_limit > 0? Stats::now() + options.time_limit: 0;
+    iterations = 0;
+    stopped = STOP_NONE;
+    const bool limited = options.time_limit > 0 || options.max_iterations > 0
+        || end_time > 0;
+    solver->connect_terminator(this);
+    try {
+        if (options.lazy) {
+            Propagator lazy(solver, listener);
+            propagator = &lazy;
+            // the solve time includes the derivations inside it.
+            const double begin = stats != NULL? Stats::now(): 0;
+            const int res = lazy.solve(assumptions);
+            propagator = NULL;
+            if (stats != NULL) {
+                stats->solve_time += Stats::now() - begin;
+                stats->solves++;
+            }
+            result.iterations = lazy.iterations;
+            if (lazy.derived_empty)
+                derived_empty = true;
+            if (res == SATISFIABLE && !derived_empty) {
+                result.status = SATISFIABLE;
+                solver->read_model(result.model);
+            } else if (res == UNSATISFIABLE || derived_empty)
+                result.status = UNSATISFIABLE;
+            else
+                result.stop = stopped;
+            solver->disconnect_terminator();
+            interrupted = false;
+            return result;
+        }
+
+        while (true) {
+            if ((limited || interrupted) && terminate()) {
+                result.stop = stopped;
+                break;
+            }
+            for (auto i = assumptions.begin(); i != assumptions.end(); i++)
+                solver->assume(*i);
+            const double begin = stats != NULL? Stats::now(): 0;
+            const int res = solver->solve();
+            if (stats != NULL) {
+                stats->solve_time += Stats::now() - begin;
+                stats->solves++;
+            }
+            if (res != SATISFIABLE) {
+                result.status = res;  // 0 if terminated
+                if (res == 0)
+                    result.stop = stopped;
+                break;
+            }
+            solver->read_projected_model(model);
+            falsified.clear();
+            for (auto y = solver->ovars.begin(); y != solver->ovars.end(); y++)
+                if (model[*y] != 1)
+                    falsified.push_back(*y);
+            if (falsified.empty()) {
+                result.status = SATISFIABLE;
+                solver->read_model(result.model);
+                break;
+            }
+            result.iterations = ++iterations;
+            if (listener != NULL)
+                listener->model(model);
+            // derive a clause for each falsified output and add them at once.
+            solver->derive(clauses, sizes, falsified, model);
+            if (listener != NULL)
+                listener->derived(clauses, sizes);
+            for (int i = 0; i < sizes.size(); i++)
+                if (sizes[i] == 0)
+                    derived_empty = true;
+            if (derived_empty) {
+                result.status = UNSATISFIABLE;
+                break;
+            }
+            for (int i = 0, pos = 0; i < sizes.size(); pos += sizes[i++]) {
+                for (int j = pos; j < pos+sizes[i]; j++)
+                    solver->add(clauses[j]);
+                solver->add(0);
+            }
+        }
+    } catch (const Error& e) {
+        propagator = NULL;
+        result.status = 0;
+        result.error = fail(e);
+        result.message = message;
+    }
+    if (!failed)
+        solver->disconnect_terminator();
+    interrupted = false;
+    return result;
+}
+
+void Engine::print_summary (Writer& out)
+{
+    if (options.minimize)
+        solver->print_minimized_total(out);
+    if (options.filter)
+        filter.print(out);
+    solver->print_elapsed(out);
+}
+
+}
@@ -0,0 +1,112 @@
+#ifndef albatross_engine_h
+#define albatross_engine_h
+
+#include <string>
+#include <vector>
+#include <atomic>
+
+#include "albatross.hpp"
+
+namespace Albatross {
+
+struct Options {
+    bool minimize     = false;
+    bool lazy         = false;  // derive inside a single solve() call
+    bool defer_ovars  = false;
+    int  load_threads = 1;
+    bool keep_clauses = false;  // needed by save_snapshot()
+    bool keep_names   = false;
+    bool filter       = false;  // drop duplicate and subsumed clauses
+    // limits of each solve(), 0: none. the status is 0 if one is reached.
+    double    time_limit     = 0;  // seconds
+    long long max_iterations = 0;
+};
+
+// why a run stopped without an answer.
+enum StopReason {
+    STOP_NONE,
+    STOP_INTERRUPT,        // by interrupt()
+    STOP_TIME_LIMIT,       // by options.time_limit or set_deadline()
+    STOP_ITERATION_LIMIT,  // by options.max_iterations
+};
+
+struct Result {
+    int       status;      // SATISFIABLE, UNSATISFIABLE, or 0 on error
+    StopReason stop;       // if status is 0 without an error
+    ErrorCode error;
+    std::string message;   // of the error
+    long long iterations;  // models falsifying an output variable
+    std::vector<int> model;  // +1 or -1 for each variable, if SATISFIABLE
+};
+
+// runs Albatross on a formula loaded once, any number of times under
+// different assumptions. clauses derived by a run are kept for later
+// runs. errors are returned instead of exiting, after which the engine
+// only returns ERROR_STATE.
+class Engine : private CaDiCaL::Terminator {
+    Options      options;
+    Solver*      solver;
+    ClauseFilter filter;
+    Stats*       stats;
+    bool         loaded;
+    bool         failed;
+    bool         derived_empty;  // no assignment can satisfy the outputs
+    std::string  message;
+    std::vector<int> model, falsified, clauses, sizes;
+    // limits of the current solve()
+    std::atomic<bool> interrupted;
+    double       deadline;
+    double       end_time;   // of set_deadline(), 0: none
+    StopReason   stopped;
+    long long    iterations;
+    Propagator*  propagator;  // of the current lazy solve()
+
+    ErrorCode fail (const Error& e);
+    bool stop (StopReason reason);
+    bool terminate ();
+
+public:
+    static const int SATISFIABLE   = 10;
+    static const int UNSATISFIABLE = 20;
+
+    Engine (const Options& o = Options());
+    ~Engine ();
+    Engine (const Engine&) = delete;
+    Engine& operator= (const Engine&) = delete;
+
+    // reads a CNF or snapshot from path, "-" for stdin, file, or the
+    // size bytes at data.
+    ErrorCode load (const char *path);
+    ErrorCode load (FILE *file);
+    ErrorCode load (const char *data, size_t size);
+    ErrorCode save_snapshot (const char *path);
+
+    // times the phases of the following runs in s.
+    void set_stats (Stats* s);
+
+    // finds a model satisfying all output variables under assumptions,
+    // calling listener, if any, on each iteration.
+    Result solve (const std::vector<int>& assumptions = std::vector<int>(),
+        Listener* listener = NULL);
+
+    // stops the current or next solve() with status 0, or load() with
+    // ERROR_STOPPED, from any thread.
+    void interrupt (void) {interrupted = true;}
+
+    // stops load() and every solve() once seconds have passed from now,
+    // unlike options.time_limit, which applies to each solve(). 0: none.
+    void set_deadline (double seconds);
+
+    // why the last load() or solve() stopped early, if it did.
+    StopReason stop_reason (void) const {return stopped;}
+
+    const std::string& error_message (void) const {return message;}
+    Solver& get_solver (void) {return *solver;}
+
+    // prints the minimisation and filter counters and elapsed time.
+    void print_summary (Writer& out);
+};
+
+}
+
+#endif
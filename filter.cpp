@@ -0,0 +1,117 @@
+#include <algorithm>
+
+#include "filter.hpp"
+
+namespace Albatross {
+
+
+ClauseFilter::ClauseFilter ()
+        : stamp (0), checked (0), duplicates (0), subsumed (0), flagged (0)
+{
+}
+
+// whether all literals of c are marked.
+bool ClauseFilter::subsumes (const Clause& c)
+{
+    for (int k = c.pos; k < c.pos + c.size; k++)
+        if (marks[index(lits[k])] != stamp)
+            return false;
+    return true;
+}
+
+bool ClauseFilter::add (const int *begin, const int *end)
+{
+    checked++;
+    if (begin == end)
+        return true;
+    tmp.assign(begin, end);
+    std::sort(tmp.begin(), tmp.end());
+    tmp.erase(std::unique(tmp.begin(), tmp.end()), tmp.end());
+    const int size = tmp.size();
+
+    uint64_t hash = 14695981039346656037ULL;  // FNV-1a
+    uint64_t sig  = 0;
+    int max_index = 0;
+    for (auto i = tmp.begin(); i != tmp.end(); i++) {
+        hash = (hash ^ (uint32_t)*i) * 1099511628211ULL;
+        sig |= 1ULL << ((*i < 0? -*i: *i) & 63);
+        max_index = std::max(max_index, index(*i));
+    }
+    if (occs.size() <= max_index) {
+        occs.resize(max_index+1);
+        marks.resize(max_index+1, 0);
+    }
+
+    auto range = table.equal_range(hash);
+    for (auto i = range.first; i != range.second; i++) {
+        const Clause& c = clauses[i->second];
+        if (c.size == size
+            && std::equal(tmp.begin(), tmp.end(), lits.begin()+c.pos)) {
+            duplicates++;
+            return false;
+        }
+    }
+
+    stamp++;
+    for (auto i = tmp.begin(); i != tmp.end(); i++)
+        marks[index(*i)] = stamp;
+
+    // forward: a kept clause whose literals are all in the new one is
+    // found in the occurrences of its first literal.
+    for (auto i = tmp.begin(); i != tmp.end(); i++) {
+        const std::vector<int>& occ = occs[index(*i)];
+        for (auto j = occ.begin(); j != occ.end(); j++) {
+            const Clause& c = clauses[*j];
+            if (lits[c.pos] != *i || c.size > size || (c.sig & ~sig) != 0)
+                continue;
+            if (subsumes(c)) {
+                subsumed++;
+                return false;
+            }
+        }
+    }
+
+    // backward: a kept clause containing all the new literals is in the
+    // occurrences of each of them, so only the shortest list is scanned.
+    int best = index(tmp[0]);
+    for (auto i = tmp.begin()+1; i != tmp.end(); i++)
+        if (occs[index(*i)].size() < occs[best].size())
+            best = index(*i);
+    std::vector<int>& occ = occs[best];
+    for (auto j = occ.begin(); j != occ.end(); j++) {
+        Clause& c = clauses[*j];
+        if (c.subsumed || c.size < size || (sig & ~c.sig) != 0)
+            continue;
+        int count = 0;
+        for (int k = c.pos; k < c.pos + c.size; k++)
+            if (marks[index(lits[k])] == stamp)
+                count++;
+        if (count == size) {
+            c.subsumed = true;
+            flagged++;
+        }
+    }
+
+    const int id = clauses.size();
+    clauses.push_back(Clause{(int)lits.size(), size, sig, false});
+    lits.insert(lits.end(), tmp.begin(), tmp.end());
+    table.emplace(hash, id);
+    for (auto i = tmp.begin(); i != tmp.end(); i++) {
+        // drops subsumed clauses while here.
+        std::vector<int>& o = occs[index(*i)];
+        o.erase(std::remove_if(o.begin(), o.end(),
+            [this] (int c) {return clauses[c].subsumed;}), o.end());
+        o.push_back(id);
+    }
+    return true;
+}
+
+void ClauseFilter::print (Writer& out)
+{
+    out << "c filter: checked " << checked
+        << " duplicates " << duplicates
+        << " subsumed " << subsumed
+        << " flagged " << flagged << '\n';
+}
+
+}
@@ -0,0 +1,45 @@
+#ifndef albatross_filter_h
+#define albatross_filter_h
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+#include "writer.hpp"
+
+namespace Albatross {
+
+// keeps the derived clauses given to CaDiCaL, sorted and hashed, to reject
+// duplicates and clauses subsumed by a kept one (forward subsumption), and
+// to flag kept clauses subsumed by a new one (backward subsumption).
+class ClauseFilter {
+    struct Clause {
+        int      pos, size;  // literals in lits
+        uint64_t sig;        // bit var%64 is set for each variable
+        bool     subsumed;   // by a later clause, no longer in occs
+    };
+    std::vector<int>    lits;
+    std::vector<Clause> clauses;
+    std::unordered_multimap<uint64_t, int> table;  // hash to clause
+    std::vector<std::vector<int> > occs;  // clauses of each literal
+    std::vector<int>    marks;            // stamp of each literal
+    int                 stamp;
+    std::vector<int>    tmp;
+
+    static int index (int lit) {return 2*(lit < 0? -lit: lit) + (lit < 0);}
+    bool subsumes (const Clause& c);
+
+public:
+    long long checked, duplicates, subsumed, flagged;
+
+    ClauseFilter ();
+
+    // returns false if the clause from begin to end is a duplicate or
+    // subsumed, and otherwise keeps it.
+    bool add (const int *begin, const int *end);
+    void print (Writer& out);
+};
+
+}
+
+#endif
@@ -0,0 +1,212 @@
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "writer.hpp"
+
+// writes a complementary-encoded CNF to stdout. each gate is an AND or an
+// OR of distinct random earlier signals (witness variables or gates), and
+// each input variable is equivalent to a random signal, all encoded by
+// clauses including the output variable y. unless --sat is given, y is
+// made unsatisfiable by (~y | z) and (~y | ~z), so that a run ends when all
+// reachable input assignments are blocked.
+//
+// with --iterations T, the first k = ceil(log2 T) input variables copy the
+// first k witness variables and gates use only these, so that a run takes
+// exactly 2^k iterations.
+
+struct Params {
+    int  inputs       = 100;
+    int  witnesses    = 100;
+    long long gates   = 1000;
+    int  min_fanin    = 2;
+    int  max_fanin    = 3;
+    long long side_clauses = 0; // random clauses over the input variables
+    int  min_len      = 2;
+    int  max_len      = 3;
+    long long iterations = 0;
+    bool sat          = false;
+    int  seed         = 1;
+};
+
+static void usage (const char *name)
+{
+    std::cerr << "Usage: " << name << " [--inputs N] [--witnesses N]"
+        << " [--gates N] [--min-fanin K] [--max-fanin K]"
+        << " [--side-clauses N] [--min-len K] [--max-len K]"
+        << " [--iterations T] [--sat] [--seed S]" << std::endl;
+    exit(EXIT_FAILURE);
+}
+
+// generates the clauses, only counting them if out is NULL.
+static long long generate (const Params& p, int k, Albatross::Writer* out)
+{
+    std::mt19937_64 rng(p.seed);
+    const int y = 1;
+    const int first_input = 2;
+    const int first_witness = first_input + p.inputs;
+    const long long first_gate = first_witness + p.witnesses;
+    long long nof_clauses = 0;
+    std::vector<long long> lits;
+
+    auto emit = [&] (void) {
+        nof_clauses++;
+        if (out == NULL)
+            return;
+        for (auto i = lits.begin(); i != lits.end(); i++)
+            *out << *i << ' ';
+        *out << "0\n";
+    };
+    // witnesses and gates usable as inputs of the gate g.
+    auto random_signal = [&] (long long g) {
+        const long long nof_witnesses = k > 0? k: p.witnesses;
+        const long long n = nof_witnesses + (g - first_gate);
+        long long s = std::uniform_int_distribution<long long>(0, n-1)(rng);
+        return s < nof_witnesses? first_witness + s:
+            first_gate + (s - nof_witnesses);
+    };
+
+    std::vector<long long> ins;
+    for (long long g = first_gate; g < first_gate + p.gates; g++) {
+        const long long n = (k > 0? k: p.witnesses) + (g - first_gate);
+        const int fanin = std::min<long long>(n,
+            std::uniform_int_distribution<int>(p.min_fanin, p.max_fanin)(rng));
+        ins.clear();
+        while (ins.size() < fanin) {
+            const long long s = random_signal(g);
+            if (std::find(ins.begin(), ins.end(), s) == ins.end())
+                ins.push_back(s);
+        }
+        for (auto i = ins.begin(); i != ins.end(); i++)
+            if (rng() & 1)
+                *i = -*i;
+        // AND: g -> s_i and s_1 & ... -> g, and OR dually.
+        const long long sign = rng() & 1? 1: -1;
+        for (auto i = ins.begin(); i != ins.end(); i++) {
+            lits = {y, -sign*g, sign*(*i)};
+            emit();
+        }
+        lits = {y, sign*g};
+        for (auto i = ins.begin(); i != ins.end(); i++)
+            lits.push_back(-sign*(*i));
+        emit();
+    }
+
+    for (int i = 0; i < p.inputs; i++) {
+        const long long x = first_input + i;
+        long long s = i < k? first_witness + i: random_signal(first_gate + p.gates);
+        if (rng() & 1)
+            s = -s;
+        lits = {y, -x, s};
+        emit();
+        lits = {y, x, -s};
+        emit();
+    }
+
+    for (long long c = 0; c < p.side_clauses; c++) {
+        const int len = std::min(p.inputs,
+            std::uniform_int_distribution<int>(p.min_len, p.max_len)(rng));
+        lits.clear();
+        while (lits.size() < len) {
+            const long long x = first_input
+                + std::uniform_int_distribution<int>(0, p.inputs-1)(rng);
+            if (std::find(lits.begin(), lits.end(), x) == lits.end()
+                && std::find(lits.begin(), lits.end(), -x) == lits.end())
+                lits.push_back(rng() & 1? x: -x);
+        }
+        emit();
+    }
+
+    if (p.sat) {
+        // y holds if the first input is true.
+        lits = {-y, first_input};
+        emit();
+    } else {
+        const long long z = first_gate + p.gates;
+        lits = {-y, z};
+        emit();
+        lits = {-y, -z};
+        emit();
+    }
+    return nof_clauses;
+}
+
+int main (int argc, char **argv)
+{
+    Params p;
+    for (int i = 1; i < argc; i++) {
+        long long arg = 0;
+        const bool has_arg = strcmp(argv[i], "--sat") != 0;
+        if (has_arg) {
+            if (i+1 >= argc)
+                usage(argv[0]);
+            arg = atoll(argv[i+1]);
+        }
+        if (strcmp(argv[i], "--inputs") == 0)
+            p.inputs = arg;
+        else if (strcmp(argv[i], "--witnesses") == 0)
+            p.witnesses = arg;
+        else if (strcmp(argv[i], "--gates") == 0)
+            p.gates = arg;
+        else if (strcmp(argv[i], "--min-fanin") == 0)
+            p.min_fanin = arg;
+        else if (strcmp(argv[i], "--max-fanin") == 0)
+            p.max_fanin = arg;
+        else if (strcmp(argv[i], "--side-clauses") == 0)
+            p.side_clauses = arg;
+        else if (strcmp(argv[i], "--min-len") == 0)
+            p.min_len = arg;
+        else if (strcmp(argv[i], "--max-len") == 0)
+            p.max_len = arg;
+        else if (strcmp(argv[i], "--iterations") == 0)
+            p.iterations = arg;
+        else if (strcmp(argv[i], "--seed") == 0)
+            p.seed = arg;
+        else if (strcmp(argv[i], "--sat") == 0)
+            p.sat = true;
+        else
+            usage(argv[0]);
+        if (has_arg)
+            i++;
+    }
+    if (p.inputs < 1 || p.witnesses < 1 || p.gates < 0
+        || p.min_fanin < 1 || p.max_fanin < p.min_fanin
+        || p.side_clauses < 0 || p.min_len < 1 || p.max_len < p.min_len
+        || p.iterations < 0)
+        usage(argv[0]);
+
+    int k = 0;
+    if (p.iterations > 0) {
+        while (k < 62 && (1LL << k) < p.iterations)
+            k++;
+        k = std::max(k, 1);
+        if (k > p.inputs || k > p.witnesses || p.side_clauses > 0 || p.sat) {
+            std::cerr << "ERROR: --iterations needs at least " << k
+                << " inputs and witnesses, and no --side-clauses or --sat."
+                << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    const long long nof_vars = 1 + p.inputs + p.witnesses + p.gates + (p.sat? 0: 1);
+    if (nof_vars > INT32_MAX) {
+        std::cerr << "ERROR: Too many variables." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    const long long nof_clauses = generate(p, k, NULL);
+
+    Albatross::Writer out(stdout);
+    out << "p cnf " << nof_vars << ' ' << nof_clauses << '\n';
+    out << "c OVAR 1 0 y\n";
+    for (int i = 0; i < p.inputs; i++)
+        out << "c IVAR " << 2+i << " 0 x" << i+1 << '\n';
+    for (int i = 0; i < p.witnesses; i++)
+        out << "c WVAR " << 2+p.inputs+i << " 0 w" << i+1 << '\n';
+    generate(p, k, &out);
+    return 0;
+}
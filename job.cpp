@@ -0,0 +1,147 @@
+#include <cstdlib>
+
+#include "job.hpp"
+
+namespace Albatross {
+
+
+const char* job_usage (void)
+{
+    return "[--minimize] [--lazy] [--defer-ovars]"
+        " [--load-threads N] [--save-snapshot FILE]"
+        " [--verbosity quiet|summary|trace] [--async-output] [--keep-names]"
+        " [--stats] [--stats-file FILE] [--filter]"
+        " [--time-limit S] [--max-iterations N]"
+        " [dimacs.cnf|-]";
+}
+
+bool parse_job (const std::vector<std::string>& args, Job& job)
+{
+    bool has_path = false;
+    for (int i = 0; i < args.size(); i++) {
+        const std::string& arg = args[i];
+        const bool has_next = i+1 < args.size();
+        if (arg == "--minimize")
+            job.options.minimize = true;
+        else if (arg == "--lazy")
+            job.options.lazy = true;
+        else if (arg == "--defer-ovars")
+            job.options.defer_ovars = true;
+        else if (arg == "--load-threads" && has_next) {
+            job.options.load_threads = atoi(args[++i].c_str());
+            if (job.options.load_threads < 1)
+                return false;
+        }
+        else if (arg == "--save-snapshot" && has_next)
+            job.snapshot_path = args[++i];
+        else if (arg == "--verbosity" && has_next) {
+            i++;
+            if (args[i] == "quiet")
+                job.verbosity = VERBOSITY_QUIET;
+            else if (args[i] == "summary")
+                job.verbosity = VERBOSITY_SUMMARY;
+            else if (args[i] == "trace")
+                job.verbosity = VERBOSITY_TRACE;
+            else
+                return false;
+        }
+        else if (arg == "--async-output")
+            job.async_output = true;
+        else if (arg == "--keep-names")
+            job.options.keep_names = true;
+        else if (arg == "--stats")
+            job.print_stats = true;
+        else if (arg == "--stats-file" && has_next)
+            job.stats_path = args[++i];
+        else if (arg == "--filter")
+            job.options.filter = true;
+        else if (arg == "--time-limit" && has_next) {
+            job.options.time_limit = atof(args[++i].c_str());
+            if (job.options.time_limit < 0)
+                return false;
+        }
+        else if (arg == "--max-iterations" && has_next) {
+            job.options.max_iterations = atoll(args[++i].c_str());
+            if (job.options.max_iterations < 0)
+                return false;
+        }
+        else if ((arg.size() > 1 && arg[0] == '-') || has_path)
+            return false;
+        else {
+            job.path = arg;
+            has_path = true;
+        }
+    }
+    return true;
+}
+
+bool run_job (const Job& job, const std::string* cnf, Writer& out,
+    std::string& message)
+{
+    Options options = job.options;
+    options.keep_clauses = !job.snapshot_path.empty();
+    // the time limit of a job includes loading.
+    options.time_limit = 0;
+
+    Stats stats;
+    if (!job.stats_path.empty() && !stats.open(job.stats_path.c_str())) {
+        message = "Could not open: " + job.stats_path;
+        return false;
+    }
+    Engine engine(options);
+    engine.set_deadline(job.options.time_limit);
+    if (job.print_stats || !job.stats_path.empty())
+        engine.set_stats(&stats);
+    const ErrorCode code = cnf != NULL? engine.load(cnf->data(), cnf->size()):
+        engine.load(job.path.c_str());
+    if (code == ERROR_STOPPED) {
+        out << "s UNKNOWN\n";
+        return true;
+    }
+    if (code != ERROR_NONE
+        || (!job.snapshot_path.empty()
+            && engine.save_snapshot(job.snapshot_path.c_str()) != ERROR_NONE)) {
+        message = engine.error_message();
+        return false;
+    }
+
+    Solver& solver = engine.get_solver();
+    Tracer tracer(solver, out, options.minimize);
+    const bool trace = job.verbosity >= VERBOSITY_TRACE;
+    Result result = engine.solve(std::vector<int>(), trace? &tracer: NULL);
+    if (result.error != ERROR_NONE) {
+        message = result.message;
+        return false;
+    }
+    if (result.status == Engine::SATISFIABLE) {
+        out << "s SATISFIABLE\n";
+        solver.print_model(out, result.model);
+    } else if (result.status == Engine::UNSATISFIABLE)
+        out << "s UNSATISFIABLE\n";
+    else
+        out << "s UNKNOWN\n";
+
+    if (job.verbosity >= VERBOSITY_SUMMARY)
+        engine.print_summary(out);
+    if (job.print_stats)
+        stats.print(out, solver.deriver_stats());
+    return true;
+}
+
+void Tracer::model (const std::vector<int>& model)
+{
+    solver.print_assignment(out, model);
+}
+
+void Tracer::derived (const std::vector<int>& clauses,
+    const std::vector<int>& sizes)
+{
+    for (int i = 0, pos = 0; i < sizes.size(); pos += sizes[i++]) {
+        clause.assign(clauses.begin()+pos, clauses.begin()+pos+sizes[i]);
+        solver.print_derived(out, clause);
+    }
+    if (minimize)
+        solver.print_minimized(out);
+}
+
+}
@@ -0,0 +1,51 @@
+#ifndef albatross_job_h
+#define albatross_job_h
+
+#include <string>
+#include <vector>
+
+#include "engine.hpp"
+
+namespace Albatross {
+
+// a run of the command line tool, or a job of the server.
+struct Job {
+    Options     options;
+    std::string path = "-";  // stdin, or the inline CNF of a server job
+    std::string snapshot_path;
+    std::string stats_path;
+    int  verbosity    = VERBOSITY_TRACE;
+    bool print_stats  = false;
+    bool async_output = false;
+};
+
+// sets the options and path given in args on job, which keeps the others.
+// returns false on an unknown or malformed option.
+bool parse_job (const std::vector<std::string>& args, Job& job);
+const char* job_usage (void);
+
+// loads the CNF in cnf, or job.path if cnf is NULL, solves it and prints
+// the result to out as the command line tool does. returns false with
+// message on an error.
+bool run_job (const Job& job, const std::string* cnf, Writer& out,
+    std::string& message);
+
+// prints the witness assignment and derived clauses of each iteration.
+class Tracer : public Listener {
+    Solver& solver;
+    Writer& out;
+    bool minimize;
+    std::vector<int> clause;
+
+public:
+    Tracer (Solver& s, Writer& o, bool m)
+        : solver (s), out (o), minimize (m) {}
+
+    void model (const std::vector<int>& model);
+    void derived (const std::vector<int>& clauses,
+        const std::vector<int>& sizes);
+};
+
+}
+
+#endif
@@ -2,6 +2,17 @@
 #include <cassert>
 #include <cstdlib>
 #include <vector>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#ifndef NMMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #include "parser.hpp"
 
@@ -9,36 +20,186 @@ namespace Albatross {
 
 #define SKIP_AND_RETURN_UNLESS(x) do {if (!(x)) {skipLine(); return;}} while(0);
 
+static const size_t buffer_size = 1 << 20;
+
+// decompressors reading from stdin and writing to stdout, by magic bytes.
+static const struct {
+    const char* magic;
+    int         size;
+    const char* argv[4];
+} decompressors[] = {
+    {"\x1f\x8b", 2, {"gzip", "-d", "-c", NULL}},
+    {"BZh", 3, {"bzip2", "-d", "-c", NULL}},
+    {"\xfd" "7zXZ\0", 6, {"xz", "-d", "-c", NULL}},
+};
+
+FILE* open_input (const char *path, pid_t& decompressor)
+{
+    decompressor = -1;
+    if (strcmp(path, "-") == 0)
+        return stdin;
+    // close-on-exec, so that the decompressors of concurrent jobs do not
+    // hold the inputs and pipes of each other open.
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+    char magic[6];
+    ssize_t n = read(fd, magic, sizeof(magic));
+    int k = 0;
+    while (k < 3 && !(n >= decompressors[k].size
+        && memcmp(magic, decompressors[k].magic, decompressors[k].size) == 0))
+        k++;
+    if (k == 3) {
+        // a plain file is read, or memory-mapped, from the beginning.
+        if (lseek(fd, 0, SEEK_SET) != 0) {
+            close(fd);
+            return NULL;
+        }
+        return fdopen(fd, "rb");
+    }
+
+    // the decompressor runs as a separate process, overlapping with parsing.
+    int fds[2];
+    if (lseek(fd, 0, SEEK_SET) != 0 || pipe2(fds, O_CLOEXEC) != 0) {
+        close(fd);
+        return NULL;
+    }
+    decompressor = fork();
+    if (decompressor < 0) {
+        close(fd);
+        close(fds[0]);
+        close(fds[1]);
+        return NULL;
+    }
+    if (decompressor == 0) {
+        dup2(fd, 0);
+        dup2(fds[1], 1);
+        close(fd);
+        close(fds[0]);
+        close(fds[1]);
+        execvp(decompressors[k].argv[0], (char* const*)decompressors[k].argv);
+        _exit(127);
+    }
+    close(fd);
+    close(fds[1]);
+    return fdopen(fds[0], "rb");
+}
+
+void close_input (FILE *file, pid_t decompressor, const char *path)
+{
+    fclose(file);
+    if (decompressor < 0)
+        return;
+    int status;
+    if (waitpid(decompressor, &status, 0) != decompressor
+        || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        throw Error(ERROR_IO, std::string("Could not decompress: ") + path);
+    }
+}
+
+static inline bool is_space (int c)
+{
+    return (c >= 9 && c <= 13) || c == 32;
+}
+
+static inline bool is_digit (int c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// reads what is available of a file that is not memory-mapped, so that
+// clauses from a pipe are loaded as they arrive.
+inline bool Parser::refill (void)
+{
+    if (buffer == NULL)
+        return false;
+    ssize_t n;
+    do
+        n = read(fileno(file), buffer, buffer_size);
+    while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        throw Error(ERROR_IO, std::to_string(lineno) + ": Could not read input.");
+    }
+    pos = buffer;
+    end = buffer + n;
+    return n > 0;
+}
+
 inline void Parser::next (void)
 {
     if (curr_char == EOF) {
-        std::cerr << "ERROR:" << lineno 
-            << ": Reached EOF and no next char." << std::endl;
-        exit(EXIT_FAILURE);
-    }
-#ifndef NUNLOCKED
-    curr_char = getc_unlocked(file);
-#else
-    curr_char = getc(file);
-#endif
+        throw Error(ERROR_PARSE,
+            std::to_string(lineno) + ": Reached EOF and no next char.");
+    }
+    if (pos == end && !refill())
+        curr_char = EOF;
+    else
+        curr_char = (unsigned char)*pos++;
     if (curr_char == '\n')
         lineno++;
 }
 
 Parser::Parser (Solver* s, FILE* f)
-        : solver (s), file (f), lineno(1)
+        : solver (s), file (f), curr_char (0), lineno(1),
+          nof_clauses (0), warned_ovar (false), defer_ovars (false),
+          start (NULL), pos (NULL), end (NULL), buffer (NULL), map (NULL), map_size (0)
 {
+#ifndef NMMAP
+    struct stat st;
+    off_t offset = ftello(file);
+    if (fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode)
+        && offset >= 0 && offset < st.st_size) {
+        map_size = st.st_size;
+        map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        if (map == MAP_FAILED)
+            map = NULL;
+        else {
+            madvise(map, map_size, MADV_SEQUENTIAL);
+            pos = (const char*)map + offset;
+            end = (const char*)map + map_size;
+        }
+    }
+#endif
+    if (map == NULL)
+        buffer = new char[buffer_size];
+    start = pos;
     next();
 }
 
+Parser::Parser (Solver* s, const char* data, size_t size)
+        : solver (s), file (NULL), curr_char (0), lineno(1),
+          nof_clauses (0), warned_ovar (false), defer_ovars (false),
+          start (data), pos (data), end (data + size), buffer (NULL),
+          map (NULL), map_size (0)
+{
+    next();
+}
+
+Parser::~Parser ()
+{
+#ifndef NMMAP
+    if (map != NULL)
+        munmap(map, map_size);
+#endif
+    delete[] buffer;
+}
+
 inline void Parser::skipWhitespace (bool no_line_break)
 {
-    if (no_line_break) {
-        while (curr_char == '\t' || curr_char == ' ')
-            next();
-    } else {
-        while ((curr_char >= 9 && curr_char <= 13) || curr_char == 32)
-            next();
+    while (true) {
+        if (no_line_break) {
+            if (curr_char != '\t' && curr_char != ' ')
+                return;
+            while (pos < end && (*pos == '\t' || *pos == ' '))
+                pos++;
+        } else {
+            if (!is_space(curr_char))
+                return;
+            for (; pos < end && is_space(*pos); pos++)
+                if (*pos == '\n')
+                    lineno++;
+        }
+        next();
     }
 }
 
@@ -54,9 +215,8 @@ inline void Parser::skipLine (void)
 inline void Parser::abort_unless (bool x)
 {
     if (!x) {
-        std::cerr << "ERROR:" << lineno
-            << ": Unexpected char: " << curr_char << std::endl;
-        exit(EXIT_FAILURE);
+        throw Error(ERROR_PARSE, std::to_string(lineno)
+            + ": Unexpected char: " + std::to_string(curr_char));
     }
 }
 
@@ -68,12 +228,15 @@ inline int Parser::parseInt (bool no_line_break)
         negative = true;
         next(); 
     }
-    abort_unless(isdigit(curr_char));
-    int  val = 0;
-    for (; isdigit(curr_char); next())
-        val = val*10 + (curr_char - '0');
-    abort_unless((curr_char >= 9 && curr_char <= 13) || curr_char == 32
-        || curr_char == EOF);
+    abort_unless(is_digit(curr_char));
+    // scan the remaining digits directly in the buffer.
+    int  val = curr_char - '0';
+    do {
+        for (; pos < end && is_digit(*pos); pos++)
+            val = val*10 + (*pos - '0');
+    } while (pos == end && refill());
+    next();
+    abort_unless(is_space(curr_char) || curr_char == EOF);
     return negative ? -val : val;
 }
 
@@ -137,6 +300,12 @@ void Parser::readComment (std::vector<char>& name, std::vector<int>& lits)
         SKIP_AND_RETURN_UNLESS(' ' == curr_char || '\t' == curr_char);
         readVar(idx, name);
         solver->set_variable(idx, CECD_OVAR, &name[0], name.size());
+        if (nof_clauses > 0 && !defer_ovars && !warned_ovar) {
+            std::cerr << "WARNING:" << lineno << ": OVAR declared after "
+                << "clauses; earlier clauses are not routed to the deriver "
+                << "(use --defer-ovars)." << std::endl;
+            warned_ovar = true;
+        }
     } else if ('W' == curr_char) {
         next();
         SKIP_AND_RETURN_UNLESS('V' == curr_char); next();
@@ -150,7 +319,35 @@ void Parser::readComment (std::vector<char>& name, std::vector<int>& lits)
     skipLine();
 }
 
-void Parser::parse_dimacs (void)
+inline bool Parser::hasOvar (const std::vector<int>& lits)
+{
+    for (auto i = lits.begin(); i != lits.end(); i++)
+        if (solver->is_ovar(std::abs(*i)))
+            return true;
+    return false;
+}
+
+inline void Parser::addClause
+    (std::vector<int>& lits, std::vector<int>* deferred)
+{
+    solver->add_clause(lits);
+    if ((++nof_clauses & 4095) == 0)
+        solver->check_load_stopped();
+    // add all clauses including output variables to deriver.
+    // NOTE: unless deferred, all comment lines declaring the output
+    //       variable should be present before clause lines.
+    //       all clauses in complementary encoding are assumed to
+    //       include the output variable.
+    if (deferred != NULL) {
+        deferred->insert(deferred->end(), lits.begin(), lits.end());
+        deferred->push_back(0);
+    } else if (hasOvar(lits))
+        solver->add_clause_to_deriver(lits);
+}
+
+// reads all lines. if deferred is not NULL, clauses are appended to it,
+// each terminated by 0, instead of being routed to the deriver.
+void Parser::readLines (std::vector<int>* deferred)
 {
     std::vector<int>  lits;
     std::vector<char> name;
@@ -171,25 +368,161 @@ void Parser::parse_dimacs (void)
             readComment(name, lits);
         else {
             readClause(lits, false); // allowing line break
-            solver->clause(lits);
-            // add all clauses including output variables to deriver.
-            // NOTE: all comment lines declaring the output variable should be 
-            //       present before clause lines
-            //       all clauses in complementary encoding are assumed to
-            //       include the output variable.
-            bool found = false;
-            for (auto i = lits.begin(); i != lits.end(); i++) {
-                for (auto j = solver->ovars.begin(); j != solver->ovars.end(); j++) {
-                    if (std::abs(*i) == *j) {
-                        found = true;
-                        solver->add_clause_to_deriver(lits);
-                        break;
-                    }
+            addClause(lits, deferred);
+        }
+    }
+}
+
+// a part of the input starting at a line, tokenised by a worker thread
+// as if no clause were open at its beginning.
+struct Chunk {
+    struct Comment {
+        size_t nof_lits;    // lits read before the comment
+        const char* at;
+        int line;           // line breaks in the chunk before the comment
+    };
+    const char* begin;
+    const char* end;
+    std::vector<int> lits;  // clauses, each terminated by 0
+    std::vector<Comment> comments;
+    int  nof_lines;
+    bool starts_with_line;  // the first token is a comment or p line
+    bool failed;            // left to the sequential parser to report
+};
+
+static void tokenize_chunk (Chunk& c)
+{
+    const char* p = c.begin;
+    const char* e = c.end;
+    bool open = false;
+    c.nof_lines = 0;
+    c.starts_with_line = c.failed = false;
+    while (true) {
+        for (; p < e && is_space(*p); p++)
+            if (*p == '\n')
+                c.nof_lines++;
+        if (p == e)
+            return;
+        if (*p == 'c' || *p == 'p') {
+            if (open || (*p == 'p' && !(e-p >= 6
+                && (p[1] == ' ' || p[1] == '\t') && p[2] == 'c'
+                && p[3] == 'n' && p[4] == 'f'
+                && (p[5] == ' ' || p[5] == '\t')))) {
+                c.failed = true;
+                return;
+            }
+            if (c.lits.empty())
+                c.starts_with_line = true;
+            if (*p == 'c')
+                c.comments.push_back(Chunk::Comment{c.lits.size(), p,
+                    c.nof_lines});
+            p = (const char*)memchr(p, '\n', e-p);
+            if (p == NULL)
+                p = e;
+            continue;
+        }
+        bool negative = false;
+        if (*p == '-') {
+            negative = true;
+            p++;
+        }
+        if (p == e || !is_digit(*p)) {
+            c.failed = true;
+            return;
+        }
+        int val = 0;
+        for (; p < e && is_digit(*p); p++)
+            val = val*10 + (*p - '0');
+        if (p < e && !is_space(*p)) {
+            c.failed = true;
+            return;
+        }
+        c.lits.push_back(negative ? -val : val);
+        open = val != 0;
+    }
+}
+
+// splits the input in memory at line breaks, tokenises the parts in parallel
+// and feeds them in file order. returns false without feeding anything
+// if the input has to be read sequentially, e.g. to report an error.
+bool Parser::readChunks (std::vector<int>* deferred, int nof_threads)
+{
+    if (buffer != NULL || curr_char == EOF)
+        return false;
+    std::vector<Chunk> chunks;
+    const size_t chunk_size = (end - start)/nof_threads + 1;
+    for (const char* p = start; p < end; ) {
+        const char* q = p + std::min<size_t>(chunk_size, end-p);
+        if (q < end) {
+            q = (const char*)memchr(q, '\n', end-q);
+            q = q == NULL ? end : q+1;
+        }
+        chunks.push_back(Chunk());
+        chunks.back().begin = p;
+        chunks.back().end = q;
+        p = q;
+    }
+    std::vector<std::thread> workers;
+    for (int i = 1; i < chunks.size(); i++)
+        workers.push_back(std::thread(tokenize_chunk, std::ref(chunks[i])));
+    tokenize_chunk(chunks[0]);
+    for (auto i = workers.begin(); i != workers.end(); i++)
+        i->join();
+
+    bool open = false;
+    for (auto i = chunks.begin(); i != chunks.end(); i++) {
+        if (i->failed || (open && i->starts_with_line))
+            return false;
+        if (!i->lits.empty())
+            open = i->lits.back() != 0;
+    }
+    if (open)
+        return false;
+
+    std::vector<int>  lits, tmp;
+    std::vector<char> name;
+    int line = 1;
+    for (auto i = chunks.begin(); i != chunks.end(); i++) {
+        size_t k = 0;
+        for (int j = 0; j <= i->comments.size(); j++) {
+            const size_t n = j < i->comments.size() ? 
+                i->comments[j].nof_lits : i->lits.size();
+            for (; k < n; k++) {
+                if (i->lits[k] != 0)
+                    lits.push_back(i->lits[k]);
+                else {
+                    addClause(lits, deferred);
+                    lits.clear();
                 }
-                if (found)
-                    break;
             }
+            if (j < i->comments.size()) {
+                pos = i->comments[j].at;
+                lineno = line + i->comments[j].line;
+                curr_char = (unsigned char)*pos++;
+                readComment(name, tmp);
+            }
+        }
+        line += i->nof_lines;
+    }
+    return true;
+}
+
+void Parser::parse_dimacs (bool defer, int nof_threads)
+{
+    defer_ovars = defer;
+    std::vector<int> deferred, lits;
+    if (nof_threads <= 1 || !readChunks(defer ? &deferred : NULL, nof_threads))
+        readLines(defer ? &deferred : NULL);
+    if (!defer)
+        return;
+    for (auto i = deferred.begin(); i != deferred.end(); i++) {
+        if (*i != 0) {
+            lits.push_back(*i);
+            continue;
         }
+        if (hasOvar(lits))
+            solver->add_clause_to_deriver(lits);
+        lits.clear();
     }
 }
 }
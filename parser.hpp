@@ -7,12 +7,25 @@
 
 namespace Albatross {
 
+// reads a memory-mapped file, a buffer in memory, or chunks of a file
+// that cannot be mapped, directly from [pos, end).
 class Parser {
     Solver* solver;
     FILE* file;
-    char curr_char;
+    int curr_char;
     int lineno;
-
+    int nof_clauses;
+    bool warned_ovar;
+    bool defer_ovars;
+
+    const char* start;
+    const char* pos;
+    const char* end;
+    char*  buffer;
+    void*  map;
+    size_t map_size;
+
+    bool refill (void);
     void next (void);
     void skipWhitespace (bool no_line_break = true);
     void skipLine (void);
@@ -22,12 +35,18 @@ class Parser {
     void readClause (std::vector<int>& lits, bool no_line_break);
     void readVar (int& idx, std::vector<char>& name);
     void readComment (std::vector<char>& name, std::vector<int>& lits);
+    bool hasOvar (const std::vector<int>& lits);
+    void addClause (std::vector<int>& lits, std::vector<int>* deferred);
+    void readLines (std::vector<int>* deferred);
+    bool readChunks (std::vector<int>* deferred, int nof_threads);
 
 public:
 
     Parser (Solver* s, FILE* f);
+    Parser (Solver* s, const char* data, size_t size);
+    ~Parser ();
 
-    void parse_dimacs (void);
+    void parse_dimacs (bool defer_ovars = false, int nof_threads = 1);
 };
 
 }
@@ -0,0 +1,76 @@
+#include <iostream>
+
+#include "albatross.hpp"
+
+namespace Albatross {
+
+
+Propagator::Propagator (Solver* s, Listener* l)
+        : solver (s), listener (l),
+          next_clause (0), next_pos (0), next_lit (0),
+          iterations (0), derived_empty (false)
+{
+    is_lazy = true;
+}
+
+int Propagator::solve (const std::vector<int>& assumptions)
+{
+    solver->connect_external_propagator(this);
+    for (auto i = solver->ivars.begin(); i != solver->ivars.end(); i++)
+        solver->add_observed_var(*i);
+    for (auto i = solver->ovars.begin(); i != solver->ovars.end(); i++)
+        solver->add_observed_var(*i);
+    for (auto i = solver->wvars.begin(); i != solver->wvars.end(); i++)
+        solver->add_observed_var(*i);
+    model.assign(solver->vars()+1, 0);
+
+    for (auto i = assumptions.begin(); i != assumptions.end(); i++)
+        solver->assume(*i);
+    int res = solver->solve();
+    solver->disconnect_external_propagator();
+    return res;
+}
+
+bool Propagator::cb_check_found_model (const std::vector<int>& lits)
+{
+    for (auto i = lits.begin(); i != lits.end(); i++)
+        model[Albatross::lit_var(*i)] = Albatross::lit_sign(*i)? -1: 1;
+    falsified.clear();
+    for (auto y = solver->ovars.begin(); y != solver->ovars.end(); y++)
+        if (model[*y] != 1)
+            falsified.push_back(*y);
+    if (falsified.empty())
+        return true;
+
+    iterations++;
+    if (listener != NULL)
+        listener->model(model);
+    solver->derive(clauses, sizes, falsified, model);
+    if (listener != NULL)
+        listener->derived(clauses, sizes);
+    for (int i = 0; i < sizes.size(); i++)
+        if (sizes[i] == 0)
+            derived_empty = true;
+    next_clause = next_pos = next_lit = 0;
+    return false;
+}
+
+bool Propagator::cb_has_external_clause (bool& is_forgettable)
+{
+    is_forgettable = false;
+    return next_clause < sizes.size();
+}
+
+// returns the literals of the next derived clause one by one, and 0 at
+// the end of the clause.
+int Propagator::cb_add_external_clause_lit ()
+{
+    assert(next_clause < sizes.size());
+    if (next_lit < sizes[next_clause])
+        return clauses[next_pos + next_lit++];
+    next_pos += sizes[next_clause++];
+    next_lit = 0;
+    return 0;
+}
+
+}
@@ -0,0 +1,244 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cctype>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "server.hpp"
+
+namespace Albatross {
+
+
+Server::Client::~Client ()
+{
+    if (owned)
+        close(fd);
+}
+
+void Server::Client::write (const char *p, size_t n)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    while (n > 0) {
+        // a client gone away does not stop the server.
+        const ssize_t k = owned? send(fd, p, n, MSG_NOSIGNAL): ::write(fd, p, n);
+        if (k < 0 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            return;
+        p += k;
+        n -= k;
+    }
+}
+
+Server::Server (const Job& d, int nof_workers)
+        : defaults (d), closing (false), next_id (1), listen_fd (-1),
+          nof_readers (0)
+{
+    for (int i = 0; i < nof_workers; i++)
+        workers.push_back(std::thread(&Server::work, this));
+}
+
+Server::~Server ()
+{
+    finish();
+}
+
+// runs the jobs queued so far and stops the workers.
+void Server::finish (void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    cond.notify_all();
+    for (auto i = workers.begin(); i != workers.end(); i++)
+        if (i->joinable())
+            i->join();
+}
+
+void Server::work (void)
+{
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [this] {return closing || !tasks.empty();});
+            if (tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        run(task);
+    }
+}
+
+// writes the whole output of task to its client at once.
+void Server::run (Task& task)
+{
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *mem = open_memstream(&buf, &len);
+    if (mem == NULL)
+        return;
+    {
+        Writer out(mem);
+        out << "c job " << task.id << " begin\n";
+        std::string message;
+        // an inline CNF is parsed where it was read.
+        const bool ok = run_job(task.job,
+            task.job.path == "-"? &task.cnf: NULL, out, message);
+        if (!ok)
+            out << "c job " << task.id << " error: " << message << '\n';
+        out << "c job " << task.id << " end\n";
+    }
+    fclose(mem);
+    task.client->write(buf, len);
+    free(buf);
+}
+
+static void split (const char *line, std::vector<std::string>& words)
+{
+    words.clear();
+    const char *p = line;
+    while (true) {
+        while (*p != '\0' && isspace((unsigned char)*p))
+            p++;
+        if (*p == '\0')
+            return;
+        const char *q = p;
+        while (*q != '\0' && !isspace((unsigned char)*q))
+            q++;
+        words.push_back(std::string(p, q));
+        p = q;
+    }
+}
+
+// queues the jobs read from in, and returns true if "shutdown" was read.
+bool Server::read_jobs (FILE *in, std::shared_ptr<Client> client)
+{
+    char *line = NULL;
+    size_t cap = 0;
+    std::vector<std::string> args, words;
+    bool shutdown = false;
+    while (getline(&line, &cap, in) >= 0) {
+        split(line, args);
+        if (args.empty())
+            continue;
+        if (args[0] == "quit")
+            break;
+        if (args[0] == "shutdown") {
+            shutdown = true;
+            break;
+        }
+        Task task;
+        task.job = defaults;
+        task.client = client;
+        // reads the CNF even if the options are malformed, to find the
+        // next job.
+        const bool inline_cnf = args.back() == "-";
+        const bool ok = parse_job(args, task.job)
+            && (task.job.path != "-" || inline_cnf);
+        if (inline_cnf) {
+            while (getline(&line, &cap, in) >= 0) {
+                split(line, words);
+                if (words.size() == 1 && words[0] == "end")
+                    break;
+                task.cnf += line;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task.id = next_id++;
+            if (ok)
+                tasks.push_back(std::move(task));
+        }
+        if (ok) {
+            cond.notify_one();
+            continue;
+        }
+        const std::string id = "c job " + std::to_string(task.id);
+        const std::string s = id + " begin\n"
+            + id + " error: Usage: " + job_usage() + '\n'
+            + id + " end\n";
+        client->write(s.data(), s.size());
+    }
+    free(line);
+    return shutdown;
+}
+
+void Server::serve_stdin (void)
+{
+    std::shared_ptr<Client> client(new Client(STDOUT_FILENO, false));
+    read_jobs(stdin, client);
+    finish();
+}
+
+void Server::read_client (std::shared_ptr<Client> client)
+{
+    FILE *in = fdopen(fcntl(client->fd, F_DUPFD_CLOEXEC, 0), "r");
+    if (in != NULL) {
+        if (read_jobs(in, client))
+            ::shutdown(listen_fd, SHUT_RDWR);  // stops accept()
+        fclose(in);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    clients.erase(std::find(clients.begin(), clients.end(), client));
+    nof_readers--;
+    readers_done.notify_all();
+}
+
+bool Server::serve_socket (const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return false;
+    strcpy(addr.sun_path, path);
+    // replaces only a socket left by an earlier server.
+    struct stat st;
+    if (stat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+        unlink(path);
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0)
+        return false;
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0
+        || listen(listen_fd, SOMAXCONN) != 0) {
+        close(listen_fd);
+        return false;
+    }
+
+    while (true) {
+        const int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break;
+        }
+        std::shared_ptr<Client> client(new Client(fd, true));
+        std::lock_guard<std::mutex> lock(mutex);
+        clients.push_back(client);
+        nof_readers++;
+        std::thread(&Server::read_client, this, client).detach();
+    }
+
+    // stops reading from the clients still connected.
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (auto i = clients.begin(); i != clients.end(); i++)
+            ::shutdown((*i)->fd, SHUT_RD);
+        readers_done.wait(lock, [this] {return nof_readers == 0;});
+    }
+    close(listen_fd);
+    unlink(path);
+    finish();
+    return true;
+}
+
+}
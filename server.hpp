@@ -0,0 +1,74 @@
+#ifndef albatross_server_h
+#define albatross_server_h
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "job.hpp"
+
+namespace Albatross {
+
+// runs jobs on a pool of worker threads, started once for all jobs. each
+// line read from stdin, or from a client of a Unix socket, is a job:
+//   [options] dimacs.cnf
+//   [options] -       followed by the lines of a CNF and a line "end"
+// with the options of the command line, on top of those the server was
+// started with. the output of each job is written at once when it ends:
+//   c job ID begin
+//   (the output of the command line tool)
+//   c job ID error: MESSAGE    (on an error)
+//   c job ID end
+// "quit" stops reading from stdin or the client, and "shutdown" also stops
+// the socket server once the jobs read so far have been run.
+class Server {
+    // where the output of jobs is written, shared by the jobs from it.
+    struct Client {
+        int  fd;
+        bool owned;   // a socket closed by the destructor
+        std::mutex mutex;
+        Client (int f, bool o) : fd (f), owned (o) {}
+        ~Client ();
+        void write (const char *p, size_t n);
+    };
+    struct Task {
+        long long   id;
+        Job         job;
+        std::string cnf;  // inline CNF, if job.path is "-"
+        std::shared_ptr<Client> client;
+    };
+
+    Job defaults;
+    std::vector<std::thread> workers;
+    std::deque<Task> tasks;
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool closing;
+    long long next_id;
+    int listen_fd;
+    std::vector<std::shared_ptr<Client> > clients;  // being read
+    int nof_readers;
+    std::condition_variable readers_done;
+
+    void finish (void);
+    void work (void);
+    void run (Task& task);
+    bool read_jobs (FILE *in, std::shared_ptr<Client> client);
+    void read_client (std::shared_ptr<Client> client);
+
+public:
+    Server (const Job& defaults, int nof_workers);
+    ~Server ();
+
+    void serve_stdin (void);
+    // returns false if the socket cannot be created.
+    bool serve_socket (const char *path);
+};
+
+}
+
+#endif
@@ -0,0 +1,199 @@
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <cstdint>
+#ifndef NMMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "albatross.hpp"
+
+namespace Albatross {
+
+// a snapshot consists of, in the native byte order:
+//   magic, number of ints in the clause stream (long long),
+//   clause stream (each clause terminated by 0),
+//   IVAR, OVAR and WVAR variables (each preceded by their number),
+//   deriver saved by upderiver_save(), including the names,
+//   checksum() of everything before it (uint64_t).
+static const char snapshot_magic[8] = {'A','L','B','S','N','A','P','3'};
+
+// FNV-1a over 8-byte words, continued from h. a single changed word always
+// changes the result. n is a multiple of 8 except at the end.
+static uint64_t checksum (uint64_t h, const char *p, size_t n)
+{
+    size_t i = 0;
+    for (; i+8 <= n; i += 8) {
+        uint64_t w;
+        memcpy(&w, p+i, 8);
+        h = (h ^ w) * 1099511628211ULL;
+    }
+    for (; i < n; i++)
+        h = (h ^ (unsigned char)p[i]) * 1099511628211ULL;
+    return h;
+}
+
+static const uint64_t checksum_basis = 14695981039346656037ULL;
+
+static void write_ints (FILE *out, const int *p, size_t n)
+{
+    if (n > 0 && fwrite(p, sizeof(int), n, out) != n) {
+        throw Error(ERROR_IO, "Could not write snapshot.");
+    }
+}
+
+static void write_vars (FILE *out, const std::vector<int>& vars)
+{
+    const int n = vars.size();
+    write_ints(out, &n, 1);
+    write_ints(out, vars.data(), vars.size());
+}
+
+static int read_int (const char **pos, const char *end)
+{
+    int x;
+    if (end - *pos < (long)sizeof(int)) {
+        throw Error(ERROR_PARSE, "Truncated snapshot.");
+    }
+    memcpy(&x, *pos, sizeof(int));
+    *pos += sizeof(int);
+    return x;
+}
+
+void Solver::save_snapshot (const char *path)
+{
+    if (!keep_clauses) {
+        throw Error(ERROR_STATE, "Clauses were not kept for a snapshot.");
+    }
+    FILE *out = fopen(path, "w+be");
+    if (out == NULL) {
+        throw Error(ERROR_IO, std::string("Could not open: ") + path);
+    }
+    const long long n = clause_stream.size();
+    try {
+        if (fwrite(snapshot_magic, 1, sizeof(snapshot_magic), out)
+                != sizeof(snapshot_magic)
+            || fwrite(&n, sizeof(n), 1, out) != 1)
+            throw Error(ERROR_IO, "Could not write snapshot.");
+        write_ints(out, clause_stream.data(), clause_stream.size());
+        write_vars(out, ivars);
+        write_vars(out, ovars);
+        write_vars(out, wvars);
+        upderiver_save(deriver, out);
+
+        // reads the snapshot back to append its checksum.
+        if (fflush(out) != 0 || fseek(out, 0, SEEK_SET) != 0)
+            throw Error(ERROR_IO, "Could not write snapshot.");
+        std::vector<char> buf(1 << 20);
+        uint64_t h = checksum_basis;
+        size_t k;
+        while ((k = fread(buf.data(), 1, buf.size(), out)) > 0)
+            h = checksum(h, buf.data(), k);
+        if (ferror(out) || fseek(out, 0, SEEK_END) != 0
+            || fwrite(&h, sizeof(h), 1, out) != 1)
+            throw Error(ERROR_IO, "Could not write snapshot.");
+    } catch (...) {
+        fclose(out);
+        throw;
+    }
+    if (fclose(out) != 0)
+        throw Error(ERROR_IO, "Could not write snapshot.");
+}
+
+// loads a snapshot if file is a memory-mappable snapshot, and otherwise
+// returns false without reading from file.
+bool Solver::read_snapshot (FILE *file)
+{
+#ifdef NMMAP
+    (void)file;
+    return false;
+#else
+    struct stat st;
+    off_t offset = ftello(file);
+    if (fstat(fileno(file), &st) != 0 || !S_ISREG(st.st_mode) || offset < 0
+        || st.st_size - offset < (off_t)(sizeof(snapshot_magic)+sizeof(long long)))
+        return false;
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if (map == MAP_FAILED)
+        return false;
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    bool is_snapshot;
+    try {
+        is_snapshot = read_snapshot((const char*)map + offset,
+            st.st_size - offset);
+    } catch (...) {
+        munmap(map, st.st_size);
+        throw;
+    }
+    munmap(map, st.st_size);
+    return is_snapshot;
+#endif
+}
+
+// loads a snapshot if [data, data+size) is one, and otherwise returns false.
+bool Solver::read_snapshot (const char *data, size_t size)
+{
+    const size_t version = sizeof(snapshot_magic)-1;
+    if (size < sizeof(snapshot_magic)+sizeof(long long)
+        || memcmp(data, snapshot_magic, version) != 0)
+        return false;
+    if (data[version] != snapshot_magic[version])
+        throw Error(ERROR_PARSE, "Unsupported snapshot version.");
+    if (size < sizeof(snapshot_magic)+sizeof(long long)+sizeof(uint64_t))
+        throw Error(ERROR_PARSE, "Truncated snapshot.");
+    const char *pos = data + sizeof(snapshot_magic);
+    const char *end = data + size - sizeof(uint64_t);
+    uint64_t h;
+    memcpy(&h, end, sizeof(h));
+    if (checksum(checksum_basis, data, end - data) != h)
+        throw Error(ERROR_PARSE, "Corrupted snapshot: checksum mismatch.");
+
+    long long n;
+    memcpy(&n, pos, sizeof(n));
+    pos += sizeof(n);
+    if (n < 0 || (end - pos)/(long)sizeof(int) < n)
+        throw Error(ERROR_PARSE, "Truncated snapshot.");
+    // a clause left open would be joined with later clauses by CaDiCaL.
+    if (n > 0) {
+        int last;
+        memcpy(&last, pos + (n-1)*sizeof(int), sizeof(int));
+        if (last != 0)
+            throw Error(ERROR_PARSE, "Malformed snapshot: unterminated clause.");
+    }
+    for (long long i = 0; i < n; i++) {
+        if ((i & 65535) == 0)
+            check_load_stopped();
+        const int lit = read_int(&pos, end);
+        if (lit == INT_MIN)
+            throw Error(ERROR_PARSE, "Malformed snapshot: invalid literal.");
+        add(lit);
+        if (keep_clauses)
+            clause_stream.push_back(lit);
+    }
+
+    // the variables are checked once the deriver is loaded.
+    std::vector<int> vars[3];
+    for (int k = 0; k < 3; k++) {
+        const int nof_vars = read_int(&pos, end);
+        if (nof_vars < 0 || (end - pos)/(long)sizeof(int) < nof_vars)
+            throw Error(ERROR_PARSE, "Truncated snapshot.");
+        for (int i = 0; i < nof_vars; i++)
+            vars[k].push_back(read_int(&pos, end));
+    }
+    if (upderiver_load(deriver, pos, end) != end)
+        throw Error(ERROR_PARSE, "Malformed snapshot: trailing data.");
+    const int extsize = upderiver_getextsize(deriver);
+    const upderiver_var_tag tags[3] = {CECD_IVAR, CECD_OVAR, CECD_WVAR};
+    for (int k = 0; k < 3; k++) {
+        for (auto i = vars[k].begin(); i != vars[k].end(); i++) {
+            if (*i <= 0 || *i >= extsize)
+                throw Error(ERROR_PARSE, "Malformed snapshot: invalid variable.");
+            tag_variable(*i, tags[k]);
+        }
+    }
+    return true;
+}
+
+}
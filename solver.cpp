@@ -8,52 +8,131 @@
 namespace Albatross {
 
 
+// reads a DIMACS file, or a snapshot written by save_snapshot().
 void Solver::read_dimacs (FILE *file)
 {
-    Parser parser(this, file);
-    parser.parse_dimacs();
+    const double begin = stats != NULL? Stats::now(): 0;
+    if (!read_snapshot(file)) {
+        Parser parser(this, file);
+        parser.parse_dimacs(defer_ovars, load_threads);
+    }
+    if (stats != NULL)
+        stats->parse_time += Stats::now() - begin;
+}
+
+void Solver::read_dimacs (const char *data, size_t size)
+{
+    const double begin = stats != NULL? Stats::now(): 0;
+    if (!read_snapshot(data, size)) {
+        Parser parser(this, data, size);
+        parser.parse_dimacs(defer_ovars, load_threads);
+    }
+    if (stats != NULL)
+        stats->parse_time += Stats::now() - begin;
 }
 
 void Solver::read_model (std::vector<int>& model)
 {
+    const double begin = stats != NULL? Stats::now(): 0;
     const int n = vars();
-    if (model.size() < n+1)
-        model.resize(n+1);
-    assert(model.size() == n+1);
+    const int size = std::max(n, max_var)+1;
+    if (model.size() < size)
+        model.resize(size);
     model[0] = 0;
     for (int i = 1; i <= n; i++)
         model[i] = val(i) > 0? 1:-1;
+    // tagged variables in no clause are false.
+    for (int i = n+1; i < size; i++)
+        model[i] = -1;
+    if (stats != NULL)
+        stats->read_model_time += Stats::now() - begin;
 }
 
-void Solver::derive (std::vector<int>& clause, std::vector<int>& model)
+// reads only the values of output and witness variables, which is all
+// derive() needs. the other entries of model are left as they are, and
+// model is only resized on the first call.
+void Solver::read_projected_model (std::vector<int>& model)
 {
-    int min_i;
-    const int max_size = ivars.size();
-    if (clause.size() < max_size)
-        clause.resize(max_size);
-    int clause_size = upderiver_derive(deriver, 
-            &clause[0], max_size,
-            &min_i,
-            &ovars[0], 1, 
+    const double begin = stats != NULL? Stats::now(): 0;
+    const int n = vars();
+    const int size = std::max(n, max_var)+1;
+    if (model.size() < size)
+        model.resize(size, 0);
+    for (auto i = ovars.begin(); i != ovars.end(); i++)
+        model[*i] = *i <= n && val(*i) > 0? 1: -1;
+    for (auto i = wvars.begin(); i != wvars.end(); i++)
+        model[*i] = *i <= n && val(*i) > 0? 1: -1;
+    if (stats != NULL)
+        stats->read_model_time += Stats::now() - begin;
+}
+
+// derives a clause for each falsified output variable, one after another
+// in clauses, with their sizes in sizes.
+void Solver::derive (std::vector<int>& clauses, std::vector<int>& sizes,
+    std::vector<int>& falsified, std::vector<int>& model)
+{
+    const double begin = stats != NULL? Stats::now(): 0;
+    const int max_size = std::max<int>(1, ivars.size()*falsified.size());
+    if (clauses.size() < max_size)
+        clauses.resize(max_size);
+    sizes.resize(falsified.size());
+    const upderiver_stats *dstats = upderiver_getstats(deriver);
+    const long long derived = dstats->total_derived;
+    const long long removed = dstats->total_removed;
+    int total_size = upderiver_derive_all(deriver, 
+            &clauses[0], max_size,
+            &sizes[0],
+            &falsified[0], falsified.size(), 
             &model[0],  model.size());
-    clause.resize(clause_size);
-    //sort(clause.begin(), clause.end());
+    clauses.resize(total_size);
+    last_derived = dstats->total_derived - derived;
+    last_removed = dstats->total_removed - removed;
+    if (stats != NULL)
+        stats->iteration(dstats, sizes, Stats::now() - begin);
+    if (filter != NULL) {
+        int n = 0, next = 0;
+        for (int i = 0, pos = 0; i < sizes.size(); pos += sizes[i++]) {
+            if (!filter->add(&clauses[0]+pos, &clauses[0]+pos+sizes[i]))
+                continue;
+            std::copy(clauses.begin()+pos, clauses.begin()+pos+sizes[i],
+                clauses.begin()+next);
+            next += sizes[i];
+            sizes[n++] = sizes[i];
+        }
+        sizes.resize(n);
+        clauses.resize(next);
+    }
 }
 
 void Solver::set_variable
     (int idx, upderiver_var_tag tag, char name[], int n)
 {
     upderiver_setvar(deriver, idx, tag, name, n);
+    tag_variable(idx, tag);
+}
 
+void Solver::tag_variable (int idx, upderiver_var_tag tag)
+{
+    max_var = std::max(max_var, idx);
     if (tag == CECD_IVAR)
         ivars.push_back(idx);
-    if (tag == CECD_OVAR)
+    if (tag == CECD_OVAR) {
         ovars.push_back(idx);
+        if (ovar_mark.size() <= idx)
+            ovar_mark.resize(idx+1, false);
+        ovar_mark[idx] = true;
+    }
     if (tag == CECD_WVAR)
         wvars.push_back(idx);
+}
 
-    if (n > 0)
-        names[idx] = std::string(name);
+void Solver::add_clause (std::vector<int>& clause)
+{
+    CaDiCaL::Solver::clause(clause);
+    if (keep_clauses) {
+        clause_stream.insert(clause_stream.end(), clause.begin(), clause.end());
+        clause_stream.push_back(0);
+    }
 }
 
 void Solver::add_clause_to_deriver (std::vector<int>& clause)
@@ -61,48 +140,72 @@ void Solver::add_clause_to_deriver (std::vector<int>& clause)
     upderiver_addclause(deriver, &clause[0], &clause[0]+clause.size());
 }
 
-void Solver::print_elapsed (std::ostream& out)
+void Solver::print_elapsed (Writer& out)
 {
     std::chrono::system_clock::time_point curr_clock = 
         std::chrono::system_clock::now();
     double elapsed =
         std::chrono::duration_cast<std::chrono::milliseconds>
         (curr_clock-start_clock).count()/1000.0;
-    out << "c elapsed(s) " << elapsed  << std::endl; 
+    out << "c elapsed(s) " << elapsed  << '\n'; 
+}
+
+void Solver::print_minimized (Writer& out)
+{
+    out << "c minimized: removed " << last_removed
+        << " of " << last_derived << '\n';
+}
+
+void Solver::print_minimized_total (Writer& out)
+{
+    const upderiver_stats *stats = upderiver_getstats(deriver);
+    out << "c minimized(total): removed " << stats->total_removed
+        << " of " << stats->total_derived << '\n';
 }
 
-void Solver::print_assignment
-    (std::ostream& out, const std::vector<int>& model)
+void Solver::print_name (Writer& out, int idx)
+{
+    const char* s = name(idx);
+    if (s != NULL)
+        out << s;
+    else
+        out << idx;
+}
+
+void Solver::print_assignment (Writer& out, const std::vector<int>& model)
 {
     out << "c assign:";
 #ifdef PRINT_BY_NAME
-    for (int i = 0; i < wvars.size(); i++)
-        out << " " << (model[wvars[i]]>0? "":"~") << names[wvars[i]];
-    std::cout << std::endl;
+    for (int i = 0; i < wvars.size(); i++) {
+        out << " " << (model[wvars[i]]>0? "":"~");
+        print_name(out, wvars[i]);
+    }
+    out << '\n';
 #else
     for (int i = 0; i < wvars.size(); i++)
-        std::cout << " " << (model[wvars[i]] > 0? "":"-") << wvars[i];
-    std::cout << std::endl;
+        out << " " << (model[wvars[i]] > 0? "":"-") << wvars[i];
+    out << '\n';
 #endif // PRINT_BY_NAME
 }
 
-void Solver::print_derived (std::ostream& out, const std::vector<int>& clause)
+void Solver::print_derived (Writer& out, const std::vector<int>& clause)
 {
     out << "c derived:";
 #ifdef PRINT_BY_NAME
-    for (auto i = clause.begin(); i != clause.end(); i++)
-        out << " " << (Albatross::lit_sign(*i)? "~":"") 
-            << names[Albatross::lit_var(*i)];
-    out << std::endl;
+    for (auto i = clause.begin(); i != clause.end(); i++) {
+        out << " " << (Albatross::lit_sign(*i)? "~":"");
+        print_name(out, Albatross::lit_var(*i));
+    }
+    out << '\n';
 #else
     for (auto i = clause.begin(); i != clause.end(); i++)
         out << " " << (Albatross::lit_sign(*i)? "-":"") 
             << Albatross::lit_var(*i);
-    out << std::endl;
+    out << '\n';
 #endif
 }
 
-void Solver::print_model (std::ostream& out, const std::vector<int>& model)
+void Solver::print_model (Writer& out, const std::vector<int>& model)
 {
     for (int i = 1; i < model.size(); i++) {
         if (i%10 == 1)
@@ -111,7 +214,7 @@ void Solver::print_model (std::ostream& out, const std::vector<int>& model)
         if (i+1 == model.size())
             out << " 0";
         if (i%10 == 0 || i+1 == model.size())
-            out << std::endl;
+            out << '\n';
     }
 }
 
@@ -0,0 +1,106 @@
+#include <cstring>
+
+#include "stats.hpp"
+
+namespace Albatross {
+
+
+Stats::Stats ()
+        : file (NULL), csv (false),
+          last_solve_time (0), last_read_model_time (0),
+          last_conflicts (0), last_propagations (0), last_watch_visits (0),
+          parse_time (0), solve_time (0), read_model_time (0), derive_time (0),
+          iterations (0), solves (0), conflicts (0),
+          derived_clauses (0), derived_literals (0)
+{
+}
+
+Stats::~Stats ()
+{
+    if (file != NULL)
+        fclose(file);
+}
+
+bool Stats::open (const char *path)
+{
+    file = fopen(path, "we");
+    if (file == NULL)
+        return false;
+    const size_t n = strlen(path);
+    csv = n >= 4 && strcmp(path+n-4, ".csv") == 0;
+    if (csv)
+        fprintf(file, "iteration,solve_s,conflicts,read_model_s,derive_s,"
+            "clauses,literals,propagations,watch_visits\n");
+    return true;
+}
+
+// records the clauses of sizes derived in time, and writes a line with
+// the differences from the last iteration.
+void Stats::iteration (const upderiver_stats *deriver,
+    const std::vector<int>& sizes, double time)
+{
+    iterations++;
+    derive_time += time;
+    long long literals = 0;
+    for (auto i = sizes.begin(); i != sizes.end(); i++) {
+        int bucket = 0;
+        for (int n = *i; n > 0; n >>= 1)
+            bucket++;
+        if (lengths.size() <= bucket)
+            lengths.resize(bucket+1, 0);
+        lengths[bucket]++;
+        literals += *i;
+    }
+    derived_clauses  += sizes.size();
+    derived_literals += literals;
+
+    if (file != NULL) {
+        const double    solve      = solve_time - last_solve_time;
+        const double    read_model = read_model_time - last_read_model_time;
+        const long long confl = conflicts - last_conflicts;
+        const long long props = deriver->propagations - last_propagations;
+        const long long visits = deriver->watch_visits - last_watch_visits;
+        if (csv)
+            fprintf(file, "%lld,%.6f,%lld,%.6f,%.6f,%zu,%lld,%lld,%lld\n",
+                iterations, solve, confl, read_model, time,
+                sizes.size(), literals, props, visits);
+        else
+            fprintf(file, "{\"iteration\": %lld, \"solve_s\": %.6f,"
+                " \"conflicts\": %lld, \"read_model_s\": %.6f,"
+                " \"derive_s\": %.6f, \"clauses\": %zu, \"literals\": %lld,"
+                " \"propagations\": %lld, \"watch_visits\": %lld}\n",
+                iterations, solve, confl, read_model, time,
+                sizes.size(), literals, props, visits);
+    }
+    last_solve_time      = solve_time;
+    last_read_model_time = read_model_time;
+    last_conflicts       = conflicts;
+    last_propagations    = deriver->propagations;
+    last_watch_visits    = deriver->watch_visits;
+}
+
+void Stats::print (Writer& out, const upderiver_stats *deriver)
+{
+    out << "c stats: iterations " << iterations
+        << " solves " << solves << '\n';
+    out << "c stats: parse(s) " << parse_time
+        << " solve(s) " << solve_time
+        << " read_model(s) " << read_model_time
+        << " derive(s) " << derive_time << '\n';
+    out << "c stats: conflicts " << conflicts
+        << " propagations " << deriver->propagations
+        << " watch_visits " << deriver->watch_visits << '\n';
+    out << "c stats: derived clauses " << derived_clauses
+        << " literals " << derived_literals << '\n';
+    out << "c stats: derived lengths:";
+    for (int i = 0; i < lengths.size(); i++) {
+        if (i <= 1)
+            out << ' ' << i;
+        else
+            out << ' ' << (1 << (i-1)) << '-' << (1 << i) - 1;
+        out << ':' << lengths[i];
+    }
+    out << '\n';
+}
+
+}
@@ -0,0 +1,54 @@
+#ifndef albatross_stats_h
+#define albatross_stats_h
+
+#include <cstdio>
+#include <vector>
+#include <chrono>
+
+#include "src/cadical.hpp"
+#include "upderiver.h"
+#include "writer.hpp"
+
+namespace Albatross {
+
+// per-phase timers and counters of a run, kept only if a Stats is given to
+// the solver. CaDiCaL conflicts are counted as learned clauses.
+class Stats : public CaDiCaL::Learner {
+    FILE* file;    // per-iteration lines, if not NULL
+    bool  csv;     // CSV instead of JSON lines
+    // totals at the end of the last iteration
+    double    last_solve_time, last_read_model_time;
+    long long last_conflicts, last_propagations, last_watch_visits;
+
+public:
+    double    parse_time, solve_time, read_model_time, derive_time;
+    long long iterations, solves, conflicts;
+    long long derived_clauses, derived_literals;
+    // derived clauses by length: 0, 1, 2-3, 4-7, ...
+    std::vector<long long> lengths;
+
+    Stats ();
+    ~Stats ();
+
+    static double now (void) {
+        return std::chrono::duration<double>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // writes a line per iteration to path, as CSV if it ends with ".csv".
+    bool open (const char *path);
+
+    bool learning (int size) {
+        conflicts++;
+        return false;
+    }
+    void learn (int lit) {}
+
+    void iteration (const upderiver_stats *deriver,
+        const std::vector<int>& sizes, double time);
+    void print (Writer& out, const upderiver_stats *deriver);
+};
+
+}
+
+#endif
@@ -0,0 +1,17 @@
+#!/bin/bash
+# Runs ./albatross on each instance with and without --minimize and checks
+# the status against the one named by its "c expect" line.
+
+cd "$(dirname "$0")/.." || exit 1
+failed=0
+for cnf in test/*.cnf; do
+    expect=$(sed -n 's/^c expect //p' $cnf)
+    for opts in "" "--minimize"; do
+        status=$(./albatross $opts $cnf | sed -n 's/^s //p')
+        if [ "$status" != "$expect" ]; then
+            echo "$cnf $opts: $status, expected $expect"
+            failed=1
+        fi
+    done
+done
+exit $failed
@@ -1,50 +1,75 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <stdint.h>
 
 #include "upderiver.h"
 
 static const int   L_TRUE       =  1;
 static const int   L_FALSE      = -1;
 static const int   L_UNDEF      =  0;
-static const int   END_OF_WLIST = -1;
 static const int   NO_REASON    = -1;
 static const bool  READABLE     = true;
 static const char* NO_HEADER    = NULL;
 
-struct st_clause;
-typedef struct st_clause clause;
+// called instead of exit() on errors, if set.
+static void (*error_hook) (void) = NULL;
 
+struct st_watcher;
+typedef struct st_watcher watcher;
+struct st_wlist;
+typedef struct st_wlist wlist;
+
+STATIC void fail (void);
 STATIC inline int  lit_neg (upderiver *deriver, int lit);
 STATIC inline int  lit_sign (upderiver *deriver, int lit);
 STATIC inline int  lit_intvar (upderiver *deriver, int lit);
 STATIC inline int  intvar_toLit (upderiver *deriver, int intvar);
+STATIC inline void check_func (upderiver *deriver, const char func[]);
+STATIC inline int  extlit_extvar (upderiver *deriver, int extlit);
+STATIC inline int  extlit_toLit (upderiver *deriver, int extlit);
+STATIC inline int  lit_toExtlit (upderiver *deriver, int lit);
 STATIC inline int model_int (upderiver *deriver,
     int model[], int model_size, int intvar);
 
-STATIC inline int  lit2val (upderiver *deriver, int lit);
+STATIC inline int  intvar_value (upderiver *deriver, int intvar);
 STATIC inline bool lit_is_satisfied (upderiver *deriver, int lit);
 STATIC inline bool lit_is_falsified (upderiver *deriver, int lit);
 
 STATIC inline int *clause_lits  (upderiver *deriver, int cls);
 STATIC inline int  clause_size  (upderiver *deriver, int cls);
-STATIC inline int *clause_watch (upderiver *deriver, int cls);
-STATIC inline int *clause_next  (upderiver *deriver, int cls);
 STATIC int clause_import (upderiver *deriver, int *begin, int *end);
 
-STATIC inline int  wlist_sentinel (upderiver *deriver, int lit);
-STATIC inline int  wlist_first (upderiver *deriver, int lit);
-STATIC inline int  wlist_next (upderiver *deriver, int cls, int lit);
-STATIC inline void wlist_push (upderiver *deriver, int cls, int lit);
-STATIC inline void wlist_change_next
-    (upderiver *deriver, int prev, int from_lit, int to_lit);
+STATIC inline wlist *wlist_of (upderiver *deriver, int lit);
+STATIC inline void wlist_push (upderiver *deriver, int lit, int cls, int blocker);
 
+STATIC void reserve_vars (upderiver *deriver, int cap);
+STATIC unsigned name_hash (const char *name);
+STATIC void name_table_insert (upderiver *deriver, int offset);
+STATIC int  intern_name (upderiver *deriver, const char *name, int n);
+STATIC const char *get_name (upderiver *deriver, int extvar);
 STATIC int import_extvar (upderiver *deriver, int extvar);
 STATIC inline void enqueue (upderiver *deriver, int lit, int cls);
 STATIC inline void assume (upderiver *deriver, int lit);
 STATIC inline void canceluntil (upderiver *deriver, int level);
+STATIC void mark_implied (upderiver *deriver);
 STATIC int derive_clause (upderiver *deriver, int *clause, int maxlen);
 STATIC int propagate (upderiver *deriver);
+STATIC int derive_for_ovar (upderiver *deriver, int extvar,
+    int *clause, int maxlen, int model[], int model_size);
+STATIC int assumed_ovar_index (upderiver *deriver,
+    int falsified_ovars[], int nof_falsified_ovars);
+
+STATIC void save_data (upderiver *deriver, FILE *out, const void *p, size_t n);
+STATIC void load_data (upderiver *deriver,
+    const char **pos, const char *end, void *p, size_t n);
+STATIC void check_snapshot (upderiver *deriver, bool ok, const char func[]);
+STATIC void check_loaded (upderiver *deriver, const char func[]);
+
+STATIC void batch_build_occs (upderiver *deriver);
+STATIC inline void batch_assign (upderiver *deriver,
+    int lit, uint64_t lanes, int *qsize);
+STATIC uint64_t batch_propagate (upderiver *deriver, uint64_t active, int qsize);
 
 STATIC void fprintlit  (FILE *out, upderiver *deriver, int lit, bool readable);
 STATIC void fprintlits (FILE *out, upderiver *deriver, 
@@ -68,7 +93,6 @@ STATIC void fprint_propagation (FILE *out, upderiver *deriver,
 STATIC bool is_intvar (upderiver *deriver, int intvar);
 STATIC bool is_clause (upderiver *deriver, int cls);
 STATIC bool clause_is_watched_by (upderiver *deriver, int cls, int lit);
-STATIC bool clause_is_sentinel (upderiver *deriver, int cls);
 STATIC void print_not_watched_error (upderiver *deriver, int cls, int lit);
 STATIC bool clause_is_unit (upderiver *deriver, int cls);
 STATIC int* trail_begin (upderiver *deriver);
@@ -78,14 +102,19 @@ STATIC int  dlevel (upderiver *deriver);
 STATIC bool upderiver_is_ivar (upderiver *deriver, int extvar);
 STATIC bool upderiver_is_ovar (upderiver *deriver, int extvar);
 STATIC bool upderiver_is_wvar (upderiver *deriver, int extvar);
-STATIC const char *get_name (upderiver *deriver, int extvar);
 #endif
 
-struct st_clause {
-    int  size;
-    int  next[2];
-    int  watch[2];
-    int* lits;
+// a clause watched by a literal, with another literal of the clause
+// that allows to skip the clause if it is satisfied.
+struct st_watcher {
+    int  cls;
+    int  blocker;
+};
+
+struct st_wlist {
+    int      size;
+    int      cap;
+    watcher* ws;
 };
 
 struct upderiver_t
@@ -101,7 +130,7 @@ struct upderiver_t
     int     qhead;
     int     qtail;
     int*    trail;
-    int*    assigns;
+    signed char* vals; // value of each literal
     int*    reasons;
     int*    trail_lim;
     int     dlevel;
@@ -109,24 +138,63 @@ struct upderiver_t
     int*    ivars; // input variables
     int*    ovars; // output variables
     int*    wvars; // witness variables
-    char**  names; // variables names
+    int*    wlits; // literals of witness variables currently assumed
+    int     ovar_assumed; // output variable negated at level 1, or -1,
+                          // the only one whose levels are kept
     bool*   is_ivar;
     bool*   is_ovar;
     bool*   is_wvar;
+    bool*   implied; // see mark_implied()
 
     int     nof_ivars;
     int     nof_ovars;
     int     nof_wvars;
 
+    // names are interned in name_arena, each terminated by '\0', and
+    // name_offs[intvar] is the offset of the name of intvar, or -1.
+    // name_table is an open addressing hash table of the offsets.
+    bool    keep_names;
+    char*   name_arena;
+    int     name_arena_size;
+    int     name_arena_cap;
+    int*    name_offs;
+    int*    name_table;
+    int     name_table_cap; // 0 or a power of two
+    int     nof_names;      // distinct names in name_arena
+
+    bool    minimize;  // remove implied literals from derived clauses
+    upderiver_stats stats;
+
     int*    buf;
     int     buf_size; // initialize and clear buf_size each time buf is used.
-
-    int     nof_clauses; // number of added clauses plus sentinels
-    int     cap_clauses;
-    clause* clauses;
-    int*    wlists;      // linked lists of clauses watched by each literal
-
-    // external functions to manipulate literals and variables
+    int*    tmp_lits; // internal literals of a clause being added
+    int     tmp_cap;
+
+    // clauses are stored one after another in arena, each as its size
+    // followed by its literals, and referred to by the offset of the size.
+    // lits[0] and lits[1] are the watched literals of a clause.
+    int     nof_clauses; // number of added clauses
+    int     arena_size;
+    int     arena_cap;
+    int*    arena;
+    wlist*  wlists;      // clauses watched by each literal
+
+    // occurrence lists and lanes for upderiver_derive_batch(), built on
+    // the first call after clauses or variables are added.
+    // lanes[lit] has the k-th bit set if lit is true for the k-th model.
+    int       occs_nof_clauses;
+    int       occs_size;
+    int*      occs_begin; // clauses with lit are in occs[occs_begin[lit]..]
+    int*      occs;
+    int       occs_max_clause_size;
+    uint64_t* lanes;
+    uint64_t* lanes_prefix;
+    bool*     lanes_queued;
+    int*      lanes_queue;
+
+    // external literals are DIMACS integers if dimacs is set, and otherwise
+    // manipulated by the following external functions.
+    bool    dimacs;
     int (*lit_neg)      (int lit);
     int (*lit_sign)     (int lit);
     int (*lit_extvar)   (int lit);
@@ -135,53 +203,80 @@ struct upderiver_t
 
 //=============================================================================
 
+// internal literals are 2*intvar for positive and 2*intvar+1 for negative
+// literals, and external literals are converted only in API functions.
 STATIC inline int lit_neg (upderiver *deriver, int lit)
 {
-    if (NULL == deriver->lit_neg) {
-        fprintf(stderr, "%sset %s with upderiver_addfunc().\n",
-            upderiver_error_header,
-            __func__);
-        exit(EXIT_FAILURE);
-    }
-    return deriver->lit_neg(lit);
+    (void)deriver;
+    return lit ^ 1;
 }
 
 STATIC inline int lit_sign (upderiver *deriver, int lit)
 {
-    if (NULL == deriver->lit_sign) {
-        fprintf(stderr, "%sset %s with upderiver_addfunc().\n",
-            upderiver_error_header,
-            __func__);
-        exit(EXIT_FAILURE);
-    }
-    return deriver->lit_sign(lit);
+    (void)deriver;
+    return lit & 1;
 }
 
 STATIC inline int lit_intvar (upderiver *deriver, int lit)
 {
-    if (NULL == deriver->lit_extvar) {
-        fprintf(stderr, "%sset %s with upderiver_addfunc().\n",
-            upderiver_error_header,
-            __func__);
-        exit(EXIT_FAILURE);
-    }
-    int extvar = deriver->lit_extvar(lit);
-    assert(extvar < deriver->extsize);
-    return deriver->intvars[extvar];
+    assert(is_intvar(deriver, lit >> 1));
+    (void)deriver;
+    return lit >> 1;
 }
 
 STATIC inline int intvar_toLit (upderiver *deriver, int intvar)
 {
-    if (NULL == deriver->extvar_toLit) {
-        fprintf(stderr, "%sset %s with upderiver_addfunc().\n",
+    assert(is_intvar(deriver, intvar));
+    (void)deriver;
+    return 2*intvar;
+}
+
+STATIC void fail (void)
+{
+    if (NULL != error_hook)
+        error_hook();
+    exit(EXIT_FAILURE);
+}
+
+STATIC inline void check_func (upderiver *deriver, const char func[])
+{
+    if (NULL == deriver->lit_neg || NULL == deriver->lit_sign
+        || NULL == deriver->lit_extvar || NULL == deriver->extvar_toLit) {
+        fprintf(stderr, "%sset functions used by %s with upderiver_addfunc().\n",
             upderiver_error_header,
-            __func__);
-        exit(EXIT_FAILURE);
+            func);
+        fail();
     }
-    assert(0 <= intvar);
-    assert(intvar < deriver->size);
-    int extvar = deriver->extvars[intvar];
-    return deriver->extvar_toLit(extvar);
+}
+
+STATIC inline int extlit_extvar (upderiver *deriver, int extlit)
+{
+    if (deriver->dimacs)
+        return extlit < 0? -extlit: extlit;
+    check_func(deriver, __func__);
+    return deriver->lit_extvar(extlit);
+}
+
+// extlit must consist of an imported variable.
+STATIC inline int extlit_toLit (upderiver *deriver, int extlit)
+{
+    const int extvar = extlit_extvar(deriver, extlit);
+    assert(0 <= extvar && extvar < deriver->extsize);
+    const int intvar = deriver->intvars[extvar];
+    assert(is_intvar(deriver, intvar));
+    if (deriver->dimacs)
+        return 2*intvar + (extlit < 0? 1: 0);
+    return 2*intvar + (deriver->lit_sign(extlit)? 1: 0);
+}
+
+STATIC inline int lit_toExtlit (upderiver *deriver, int lit)
+{
+    const int extvar = deriver->extvars[lit_intvar(deriver, lit)];
+    if (deriver->dimacs)
+        return lit_sign(deriver, lit)? -extvar: extvar;
+    check_func(deriver, __func__);
+    const int extlit = deriver->extvar_toLit(extvar);
+    return lit_sign(deriver, lit)? deriver->lit_neg(extlit): extlit;
 }
 
 STATIC inline int model_int (upderiver *deriver,
@@ -195,27 +290,26 @@ STATIC inline int model_int (upderiver *deriver,
     if (L_UNDEF == res) {
         fprintf(stderr, "%sno model set.\n",
             upderiver_error_header);
-        exit(EXIT_FAILURE);
+        fail();
     }
     return res;
 }
 
 //=============================================================================
 
-STATIC inline int lit2val (upderiver *deriver, int lit)
+STATIC inline int intvar_value (upderiver *deriver, int intvar)
 {
-    return lit_sign(deriver, lit)? L_FALSE : L_TRUE;
+    return deriver->vals[intvar_toLit(deriver, intvar)];
 }
 
 STATIC inline bool lit_is_satisfied (upderiver *deriver, int lit)
 {
-    return lit2val(deriver, lit) == deriver->assigns[lit_intvar(deriver, lit)];
+    return L_TRUE == deriver->vals[lit];
 }
 
 STATIC inline bool lit_is_falsified (upderiver *deriver, int lit)
 {
-    return lit2val(deriver, lit_neg(deriver, lit)) 
-        == deriver->assigns[lit_intvar(deriver, lit)];
+    return L_FALSE == deriver->vals[lit];
 }
 
 //=============================================================================
@@ -223,25 +317,13 @@ STATIC inline bool lit_is_falsified (upderiver *deriver, int lit)
 STATIC inline int *clause_lits (upderiver *deriver, int cls)
 {
     assert(is_clause(deriver, cls));
-    return deriver->clauses[cls].lits;
+    return deriver->arena + cls + 1;
 }
 
 STATIC inline int clause_size (upderiver *deriver, int cls)
 {
     assert(is_clause(deriver, cls));
-    return deriver->clauses[cls].size;
-}
-
-STATIC inline int *clause_watch (upderiver *deriver, int cls)
-{
-    assert(is_clause(deriver, cls));
-    return deriver->clauses[cls].watch;
-}
-
-STATIC inline int *clause_next (upderiver *deriver, int cls)
-{
-    assert(is_clause(deriver, cls));
-    return deriver->clauses[cls].next;
+    return deriver->arena[cls];
 }
 
 STATIC int clause_import (upderiver *deriver, int *begin, int *end)
@@ -250,154 +332,188 @@ STATIC int clause_import (upderiver *deriver, int *begin, int *end)
         fprintf(stderr, "%s%s received empty clause.\n", 
             upderiver_error_header,
             __func__);
-        exit(EXIT_FAILURE);
+        fail();
     }
     if (end-begin == 1) {
         fprintf(stderr, "%s%s received unit clause.\n", 
             upderiver_error_header,
             __func__);
-        exit(EXIT_FAILURE);
+        fail();
     }
 
-    if (deriver->cap_clauses <= deriver->nof_clauses+1) {
-
-        while (deriver->cap_clauses <= deriver->nof_clauses+1)
-            deriver->cap_clauses = deriver->cap_clauses*2+1;
-
-        deriver->clauses  = (clause*)realloc(
-            deriver->clauses, 
-            sizeof(clause)*(size_t)deriver->cap_clauses);
-
-        for (int i = deriver->nof_clauses; i < deriver->cap_clauses; i++){
-            deriver->clauses[i].size  = 0;
-            deriver->clauses[i].next[0] = END_OF_WLIST;
-            deriver->clauses[i].next[1] = END_OF_WLIST;
-            deriver->clauses[i].lits  = NULL;
-        }
+    const int size = (int)(end-begin);
+    if (deriver->arena_size > INT_MAX - (size+1)) {
+        fprintf(stderr, "%s%s exceeds maximum size of clause arena.\n", 
+            upderiver_error_header,
+            __func__);
+        fail();
     }
-    assert(deriver->nof_clauses+1 < deriver->cap_clauses);
+    const int needed = deriver->arena_size + size + 1;
+    if (deriver->arena_cap < needed) {
+        long long cap = deriver->arena_cap;
+        while (cap < needed)
+            cap = cap*2+1;
+        deriver->arena_cap = cap < INT_MAX? (int)cap: INT_MAX;
+        deriver->arena = (int*)realloc(deriver->arena,
+            sizeof(int)*(size_t)deriver->arena_cap);
+    }
+    assert(needed <= deriver->arena_cap);
 
+    const int cls = deriver->arena_size;
+    deriver->arena[cls] = size;
+    for (int i = 0; i < size; i++)
+        deriver->arena[cls+1+i] = begin[i];
+    deriver->arena_size = needed;
     deriver->nof_clauses++;
-    const int cls = deriver->nof_clauses - 1;
-    clause *p = deriver->clauses + cls;
-    p->size = end-begin;
-    p->lits = (int*)malloc(sizeof(int)*(size_t)p->size);
-    for (int i = 0; i < p->size; i++)
-        p->lits[i] = begin[i];
-    p->watch[0] = lit_neg(deriver, begin[0]);
-    p->watch[1] = lit_neg(deriver, begin[1]);
     return cls;
 }
 
 //=============================================================================
 
-STATIC inline int wlist_sentinel (upderiver *deriver, int lit)
-{
-    assert(is_intvar(deriver, lit_intvar(deriver, lit)));
-    const int intvar = lit_intvar(deriver, lit);
-    return deriver->wlists[intvar];
-}
-
-STATIC inline int wlist_first (upderiver *deriver, int lit)
+// clauses watched by lit, i.e., clauses in which the negation of lit is
+// one of the first two literals.
+STATIC inline wlist *wlist_of (upderiver *deriver, int lit)
 {
     assert(is_intvar(deriver, lit_intvar(deriver, lit)));
-    int cls = wlist_sentinel(deriver, lit);
-    return wlist_next(deriver, cls, lit);
+    return deriver->wlists + lit;
 }
 
-STATIC inline int wlist_next (upderiver *deriver, int cls, int lit)
+STATIC inline void wlist_push (upderiver *deriver, int lit, int cls, int blocker)
 {
     assert(is_intvar(deriver, lit_intvar(deriver, lit)));
     assert(is_clause(deriver, cls));
 #ifndef NDEBUG
     if (!clause_is_watched_by(deriver, cls, lit)) {
         print_not_watched_error(deriver, cls, lit);
-        exit(EXIT_FAILURE);
+        fail();
     }
 #endif
-    for (int i = 0; i < 2; i++)
-        if (lit == clause_watch(deriver, cls)[i])
-            return clause_next(deriver, cls)[i];
 
-    fprintf(stderr, "%s%s could not find next clause.\n", 
-        upderiver_error_header,
-        __func__);
-    exit(EXIT_FAILURE);
+    wlist *wl = wlist_of(deriver, lit);
+    if (wl->size >= wl->cap) {
+        wl->cap = wl->cap*2+1;
+        wl->ws  = (watcher*)realloc(wl->ws, sizeof(watcher)*(size_t)wl->cap);
+    }
+    assert(wl->size < wl->cap);
+    wl->ws[wl->size].cls     = cls;
+    wl->ws[wl->size].blocker = blocker;
+    wl->size++;
 }
 
-STATIC inline void wlist_push (upderiver *deriver, int cls, int lit)
+//=============================================================================
+
+// reallocates each data structure of variables to hold cap variables.
+STATIC void reserve_vars (upderiver *deriver, int cap)
 {
-    assert(is_intvar(deriver, lit_intvar(deriver, lit)));
-    assert(is_clause(deriver, cls));
-    assert(!clause_is_sentinel(deriver, cls));
+    deriver->cap = cap;
+
+    deriver->extvars  = (int*)realloc(deriver->extvars,
+        sizeof(int)*(size_t)deriver->cap);
+    deriver->wlists   = (wlist*)realloc(deriver->wlists,
+        sizeof(wlist)*2*(size_t)deriver->cap);
+    deriver->is_ovar  = (bool*)realloc(deriver->is_ovar,
+        sizeof(bool)*(size_t)deriver->cap);
+    deriver->is_ivar = (bool*)realloc(deriver->is_ivar,
+        sizeof(bool)*(size_t)deriver->cap);
+    deriver->is_wvar  = (bool*)realloc(deriver->is_wvar,
+        sizeof(bool)*(size_t)deriver->cap);
+    deriver->implied  = (bool*)realloc(deriver->implied,
+        sizeof(bool)*(size_t)deriver->cap);
+    deriver->wvars = (int*) realloc(deriver->wvars,
+        sizeof(int)*(size_t)deriver->cap);
+    deriver->wlits = (int*) realloc(deriver->wlits,
+        sizeof(int)*(size_t)deriver->cap);
+    deriver->ivars = (int*) realloc(deriver->ivars,
+        sizeof(int)*(size_t)deriver->cap);
+    deriver->ovars = (int*) realloc(deriver->ovars,
+        sizeof(int)*(size_t)deriver->cap);
+    deriver->vals     = (signed char*) realloc(deriver->vals,
+        sizeof(signed char)*2*(size_t)deriver->cap);
+    deriver->reasons  = (int*) realloc(deriver->reasons,
+        sizeof(int)*(size_t)deriver->cap);
+    deriver->trail    = (int*) realloc(deriver->trail,
+        sizeof(int)*(size_t)deriver->cap);
+    deriver->name_offs = (int*)realloc(deriver->name_offs,
+        sizeof(int)*(size_t)deriver->cap);
+    deriver->trail_lim = (int*) realloc(deriver->trail_lim,
+        sizeof(int)*(size_t)deriver->cap);
+    deriver->buf      = (int*) realloc(deriver->buf,
+        sizeof(int)*(size_t)deriver->cap);
+}
 
-#ifndef NDEBUG
-    if (!clause_is_watched_by(deriver, cls, lit)) {
-        print_not_watched_error(deriver, cls, lit);
-        exit(EXIT_FAILURE);
-    }
-#endif
+// FNV-1a
+STATIC unsigned name_hash (const char *name)
+{
+    unsigned h = 2166136261u;
+    for (const char *p = name; '\0' != *p; p++)
+        h = (h ^ (unsigned char)*p) * 16777619u;
+    return h;
+}
 
-    // add current clause to wlist of lit.
-    const int sentinel = wlist_sentinel(deriver, lit);
-    int next_to_sentinel = -1;
-    for (int i = 0; i < 2; i++)
-        if (lit == clause_watch(deriver,sentinel)[i]) {
-            next_to_sentinel = clause_next(deriver,sentinel)[i];
-            deriver->clauses[sentinel].next[i] = cls;
+STATIC void name_table_insert (upderiver *deriver, int offset)
+{
+    if (2*(deriver->nof_names+1) > deriver->name_table_cap) {
+        const int old_cap = deriver->name_table_cap;
+        int *old_table = deriver->name_table;
+        if (old_cap > INT_MAX/2) {
+            fprintf(stderr, "%s%s exceeds maximum number of names.\n",
+                upderiver_error_header,
+                __func__);
+            fail();
         }
-
-    // update next field of current clause
-    for (int i = 0; i < 2; i++)
-        if (lit == clause_watch(deriver, cls)[i])
-            deriver->clauses[cls].next[i] = next_to_sentinel;
-
-#ifndef NDEBUG
-    assert(wlist_next(deriver, sentinel, lit) == cls);
-    assert(wlist_next(deriver, cls, lit)      == next_to_sentinel);
-#endif
+        deriver->name_table_cap = 0 == old_cap? 16: 2*old_cap;
+        deriver->name_table = (int*)malloc(sizeof(int)
+            *(size_t)deriver->name_table_cap);
+        for (int i = 0; i < deriver->name_table_cap; i++)
+            deriver->name_table[i] = -1;
+        deriver->nof_names = 0;
+        for (int i = 0; i < old_cap; i++)
+            if (0 <= old_table[i])
+                name_table_insert(deriver, old_table[i]);
+        free(old_table);
+    }
+    const unsigned mask = (unsigned)deriver->name_table_cap-1;
+    unsigned i = name_hash(deriver->name_arena+offset) & mask;
+    while (0 <= deriver->name_table[i])
+        i = (i+1) & mask;
+    deriver->name_table[i] = offset;
+    deriver->nof_names++;
 }
 
-// change next clause of prev so that it gets watched by to_lit.
-STATIC inline void wlist_change_next (upderiver *deriver, 
-    int prev, int from_lit, int to_lit)
+// returns the offset of name in name_arena, where n includes '\0'.
+STATIC int intern_name (upderiver *deriver, const char *name, int n)
 {
-    assert(is_clause(deriver, prev));
-    assert(is_intvar(deriver, lit_intvar(deriver, from_lit)));
-    assert(is_intvar(deriver, lit_intvar(deriver, to_lit)));
-    int curr = wlist_next(deriver, prev, from_lit);
-#ifndef NDEBUG
-    {
-        bool found = false;
-        int *begin = clause_lits(deriver, curr);
-        int *end   = begin + clause_size(deriver, curr);
-        for (int *i = begin; i < end; i++)
-            if (lit_neg(deriver, to_lit) == *i) {
-                found = true;
-                break;
-            }
-        assert(found);
+    if (0 < deriver->name_table_cap) {
+        const unsigned mask = (unsigned)deriver->name_table_cap-1;
+        for (unsigned i = name_hash(name) & mask;
+            0 <= deriver->name_table[i]; i = (i+1) & mask) {
+            const int offset = deriver->name_table[i];
+            if (0 == strcmp(deriver->name_arena+offset, name))
+                return offset;
+        }
     }
-#endif
-
-    // remove current clause from wlist of from_lit.
-    const int next = wlist_next(deriver, curr, from_lit);
-    for (int i = 0; i < 2; i++)
-        if (from_lit == clause_watch(deriver, prev)[i])
-            deriver->clauses[prev].next[i] = next;
-    assert(wlist_next(deriver, prev, from_lit) == next);
-
-    // update watch of current clause
-    for (int i = 0; i < 2; i++)
-        if (from_lit == clause_watch(deriver, curr)[i])
-            deriver->clauses[curr].watch[i] = to_lit;
-
-    // add current clause to wlist of to_lit.
-    wlist_push(deriver, curr, to_lit);
+    if (deriver->name_arena_size > INT_MAX - n) {
+        fprintf(stderr, "%s%s exceeds maximum size of name arena.\n",
+            upderiver_error_header,
+            __func__);
+        fail();
+    }
+    const int needed = deriver->name_arena_size + n;
+    if (deriver->name_arena_cap < needed) {
+        long long cap = deriver->name_arena_cap;
+        while (cap < needed)
+            cap = cap*2+1;
+        deriver->name_arena_cap = cap < INT_MAX? (int)cap: INT_MAX;
+        deriver->name_arena = (char*)realloc(deriver->name_arena,
+            sizeof(char)*(size_t)deriver->name_arena_cap);
+    }
+    const int offset = deriver->name_arena_size;
+    memcpy(deriver->name_arena+offset, name, (size_t)n);
+    deriver->name_arena_size = needed;
+    name_table_insert(deriver, offset);
+    return offset;
 }
 
-//=============================================================================
-
 STATIC int import_extvar_main (upderiver *deriver, int extvar)
 {
     assert(extvar < deriver->extsize);
@@ -410,37 +526,10 @@ STATIC int import_extvar_main (upderiver *deriver, int extvar)
     
     // reallocate each data structure if necessary to set intvar.
     if (intvar >= deriver->cap){
-        while (intvar >= deriver->cap)
-          deriver->cap = deriver->cap*2+1;
-
-        deriver->extvars  = (int*)realloc(deriver->extvars,
-            sizeof(int)*(size_t)deriver->cap);
-        deriver->wlists   = (int*)realloc(deriver->wlists,
-            sizeof(int)*(size_t)deriver->cap);
-        deriver->is_ovar  = (bool*)realloc(deriver->is_ovar,
-            sizeof(bool)*(size_t)deriver->cap);
-        deriver->is_ivar = (bool*)realloc(deriver->is_ivar,
-            sizeof(bool)*(size_t)deriver->cap);
-        deriver->is_wvar  = (bool*)realloc(deriver->is_wvar,
-            sizeof(bool)*(size_t)deriver->cap);
-        deriver->wvars = (int*) realloc(deriver->wvars,
-            sizeof(int)*(size_t)deriver->cap);
-        deriver->ivars = (int*) realloc(deriver->ivars,
-            sizeof(int)*(size_t)deriver->cap);
-        deriver->ovars = (int*) realloc(deriver->ovars,
-            sizeof(int)*(size_t)deriver->cap);
-        deriver->assigns  = (int*) realloc(deriver->assigns,
-            sizeof(int)*(size_t)deriver->cap);
-        deriver->reasons  = (int*) realloc(deriver->reasons,
-            sizeof(int)*(size_t)deriver->cap);
-        deriver->trail    = (int*) realloc(deriver->trail,
-            sizeof(int)*(size_t)deriver->cap);
-        deriver->names    = (char**)realloc(deriver->names,
-            sizeof(char*)*(size_t)deriver->cap);
-        deriver->trail_lim = (int*) realloc(deriver->trail_lim,
-            sizeof(int)*(size_t)deriver->cap);
-        deriver->buf      = (int*) realloc(deriver->buf,
-            sizeof(int)*(size_t)deriver->cap);
+        int cap = deriver->cap;
+        while (intvar >= cap)
+          cap = cap*2+1;
+        reserve_vars(deriver, cap);
     }
     assert(intvar < deriver->cap);
     assert(intvar+1 == deriver->size);
@@ -449,15 +538,17 @@ STATIC int import_extvar_main (upderiver *deriver, int extvar)
     deriver->is_ivar [intvar] = false;
     deriver->is_ovar [intvar] = false;
     deriver->is_wvar [intvar] = false;
-    deriver->assigns [intvar] = L_UNDEF;
+    deriver->implied [intvar] = false;
+    deriver->vals    [2*intvar]   = L_UNDEF;
+    deriver->vals    [2*intvar+1] = L_UNDEF;
     deriver->reasons [intvar] = NO_REASON;
-    deriver->names   [intvar] = NULL;
+    deriver->name_offs[intvar] = -1;
 
-    int lits[2];
-    lits[0] = deriver->extvar_toLit(extvar);
-    lits[1] = deriver->lit_neg(deriver->extvar_toLit(extvar));
-    deriver->wlists[intvar] = clause_import(deriver, lits, lits+2); // sentinel
-    assert(is_clause(deriver, deriver->wlists[intvar]));
+    for (int i = 2*intvar; i < 2*intvar+2; i++) {
+        deriver->wlists[i].size = 0;
+        deriver->wlists[i].cap  = 0;
+        deriver->wlists[i].ws   = NULL;
+    }
 
     return intvar;
 }
@@ -488,22 +579,22 @@ STATIC int import_extvar (upderiver *deriver, int extvar)
 STATIC inline void enqueue (upderiver *deriver, int lit, int cls)
 {
     assert(is_intvar(deriver, lit_intvar(deriver, lit)));
-    assert(NO_REASON == cls 
-        || (is_clause(deriver, cls) && !clause_is_sentinel(deriver, cls)));
+    assert(NO_REASON == cls || is_clause(deriver, cls));
 
     if (lit_is_falsified(deriver, lit)) {
         fprintf(stderr, "%sfailed to enqueue ", 
             upderiver_error_header);
         fprintlits_nl(stderr, deriver, &lit, &lit+1, READABLE, NO_HEADER);
-        exit(EXIT_FAILURE);
+        fail();
     }
 
     if (lit_is_satisfied(deriver, lit))
         return;
 
     const int intvar = lit_intvar(deriver, lit);
-    assert (L_UNDEF == deriver->assigns[intvar]);
-    deriver->assigns[intvar] = lit2val(deriver, lit);
+    assert (L_UNDEF == intvar_value(deriver, intvar));
+    deriver->vals[lit] = L_TRUE;
+    deriver->vals[lit_neg(deriver, lit)] = L_FALSE;
     deriver->trail[deriver->qtail++] = lit;
     deriver->reasons[intvar] = cls;
     assert(lit_is_satisfied(deriver, lit));
@@ -517,17 +608,16 @@ STATIC inline void assume (upderiver *deriver, int lit)
         fprintf(stderr, "%s%s invoked without propagation.\n",
             upderiver_error_header,
             __func__);
-        exit(EXIT_FAILURE);
+        fail();
     }
     if (lit_is_falsified(deriver, lit)) {
         fprintf(stderr, "%sfailed to assume ", 
             upderiver_error_header);
         fprintlits_nl(stderr, deriver, &lit, &lit+1, READABLE, NO_HEADER);
-        exit(EXIT_FAILURE);
+        fail();
     }
-    if (lit_is_satisfied(deriver, lit))
-        return;
 
+    // a new level is opened even if lit is already satisfied.
     assert(deriver->dlevel < deriver->size);
     deriver->trail_lim[deriver->dlevel++] = deriver->qtail;
     enqueue(deriver, lit, NO_REASON);
@@ -541,7 +631,8 @@ STATIC inline void canceluntil (upderiver *deriver, int level)
     const int bound = deriver->trail_lim[level];
     for (int pos = deriver->qtail-1; pos >= bound; pos--) {
         const int lit = deriver->trail[pos];
-        deriver->assigns[lit_intvar(deriver, lit)] = L_UNDEF;
+        deriver->vals[lit] = L_UNDEF;
+        deriver->vals[lit_neg(deriver, lit)] = L_UNDEF;
         deriver->reasons[lit_intvar(deriver, lit)] = NO_REASON;
     }
 
@@ -549,23 +640,67 @@ STATIC inline void canceluntil (upderiver *deriver, int level)
     deriver->dlevel = level;
 }
 
+// marks each variable on the trail that is implied, through the reasons,
+// by the input variables on the trail and the variables at the root level
+// alone. Input variables marked so are redundant in a derived clause since
+// they are implied by the other input variables in it. the assumed negated
+// output and witness variables are never implied, since the clause is only
+// sound for the input literals that follow from them.
+STATIC void mark_implied (upderiver *deriver)
+{
+    const int root = 0 < deriver->dlevel? deriver->trail_lim[0]: deriver->qtail;
+    for (int pos = 0; pos < deriver->qtail; pos++) {
+        const int lit    = deriver->trail[pos];
+        const int intvar = lit_intvar(deriver, lit);
+        const int cls    = deriver->reasons[intvar];
+        bool implied;
+        if (pos < root)
+            implied = true;
+        else if (NO_REASON == cls)
+            implied = false;
+        else {
+            implied = true;
+            int *begin = clause_lits(deriver, cls);
+            int *end   = begin + clause_size(deriver, cls);
+            for (int *i = begin; i < end && implied; i++) {
+                const int v = lit_intvar(deriver, *i);
+                if (lit != *i)
+                    implied = deriver->is_ivar[v] || deriver->implied[v];
+            }
+        }
+        deriver->implied[intvar] = implied;
+    }
+}
+
 STATIC int derive_clause (upderiver *deriver, int *clause, int maxlen)
 {
-    int count = 0;
-    const int bound = deriver->trail_lim[deriver->dlevel-1];
+    int count   = 0;
+    int removed = 0;
+    if (deriver->minimize)
+        mark_implied(deriver);
+    const int bound = deriver->trail_lim[0];
     for (int pos = deriver->qtail-1; pos >= bound; pos--) {
         const int lit = deriver->trail[pos];
         if (deriver->is_ivar[lit_intvar(deriver, lit)]) {
+            if (deriver->minimize && deriver->implied[lit_intvar(deriver, lit)]) {
+                removed++;
+                continue;
+            }
             if (!(count < maxlen)) {
                 fprintf(stderr, "%s%s exceeds maximum length.\n",
                         upderiver_error_header,
                         __func__);
-                exit(EXIT_FAILURE);
+                fail();
             }
-            clause[count++] = lit_neg(deriver,lit);
+            clause[count++] = lit_toExtlit(deriver, lit_neg(deriver,lit));
         }
     }
 
+    deriver->stats.derived  = count + removed;
+    deriver->stats.removed  = removed;
+    deriver->stats.total_derived += count + removed;
+    deriver->stats.total_removed += removed;
+    deriver->stats.nof_derive_calls++;
     return count;
 }
 
@@ -575,49 +710,64 @@ STATIC int propagate (upderiver *deriver)
 
     while (deriver->qtail - deriver->qhead > 0){
         const int lit = deriver->trail[deriver->qhead++];
-        int prev = wlist_sentinel(deriver, lit);
-        int curr = wlist_first(deriver, lit);
-        while (0 <= curr) {
-            // negation of the other watch
-            const int neg_w_prime = lit == clause_watch(deriver, curr)[0]?
-                                lit_neg(deriver, clause_watch(deriver, curr)[1]):
-                                lit_neg(deriver, clause_watch(deriver, curr)[0]);
-            assert(lit_is_falsified(deriver, lit_neg(deriver, lit)));
-
-            if (lit_is_satisfied(deriver, neg_w_prime)) {
-                assert(!clause_is_unit(deriver, curr));
-                prev = curr;
-                curr = wlist_next(deriver, curr, lit);
-            } else {
-                int *begin = clause_lits(deriver, curr);
-                int *end   = begin + clause_size(deriver, curr);
-                bool found = false; 
-                for (int *i = begin; i < end; i++){
-                    // if new watch found:
-                    if (neg_w_prime != *i && !lit_is_falsified(deriver, *i)){
-                        found = true;
-                        int next = wlist_next(deriver, curr, lit);
-                        // remove current clause from wlist of lit and 
-                        // push it to wlist of new watch.
-                        wlist_change_next(deriver,
-                            prev, lit, lit_neg(deriver, *i));
-                        // prev is unchanged.
-                        assert(wlist_next(deriver, prev, lit) == next);
-                        curr = next;
-                        break;
-                    }
-                }
+        const int false_lit = lit_neg(deriver, lit);
+        assert(lit_is_falsified(deriver, false_lit));
+        deriver->stats.propagations++;
+
+        wlist   *wl  = wlist_of(deriver, lit);
+        watcher *i   = wl->ws;
+        watcher *j   = wl->ws;
+        watcher *end = wl->ws + wl->size;
+        deriver->stats.watch_visits += wl->size;
+        while (i < end) {
+            if (lit_is_satisfied(deriver, i->blocker)) {
+                *j++ = *i++;
+                continue;
+            }
+
+            const int cls = i->cls;
+            int *lits = clause_lits(deriver, cls);
+            if (false_lit == lits[0]) {
+                lits[0] = lits[1];
+                lits[1] = false_lit;
+            }
+            assert(false_lit == lits[1]);
+            const int first = lits[0];
+            i++;
+
+            if (lit_is_satisfied(deriver, first)) {
+                assert(!clause_is_unit(deriver, cls));
+                j->cls     = cls;
+                j->blocker = first;
+                j++;
+                continue;
+            }
 
-                // unit propagation:
-                if (!found) {
-                    assert(clause_is_unit(deriver, curr));
-                    enqueue(deriver, neg_w_prime, curr);
-                    count++;
-                    prev = curr;
-                    curr = wlist_next(deriver, curr, lit);
+            bool found = false;
+            const int size = clause_size(deriver, cls);
+            for (int k = 2; k < size; k++) {
+                // if new watch found:
+                if (!lit_is_falsified(deriver, lits[k])) {
+                    found = true;
+                    lits[1] = lits[k];
+                    lits[k] = false_lit;
+                    // move current clause to wlist of new watch.
+                    wlist_push(deriver, lit_neg(deriver, lits[1]), cls, first);
+                    break;
                 }
             }
+            if (found)
+                continue;
+
+            // unit propagation:
+            assert(clause_is_unit(deriver, cls));
+            j->cls     = cls;
+            j->blocker = first;
+            j++;
+            enqueue(deriver, first, cls);
+            count++;
         }
+        wl->size = (int)(j - wl->ws);
     }
 
 #ifndef NDEBUG
@@ -626,16 +776,20 @@ STATIC int propagate (upderiver *deriver)
         int lits[2] = {
             intvar_toLit(deriver, intvar), 
             lit_neg(deriver, intvar_toLit(deriver, intvar))};
-        for (int i = 0; i < 2; i++)
-            for (int cls = wlist_first(deriver, lits[i]);
-                0 <= cls; cls = wlist_next(deriver, cls, lits[i]))
+        for (int i = 0; i < 2; i++) {
+            wlist *wl = wlist_of(deriver, lits[i]);
+            for (int k = 0; k < wl->size; k++) {
+                const int cls = wl->ws[k].cls;
+                assert(clause_is_watched_by(deriver, cls, lits[i]));
                 if (clause_is_unit(deriver, cls)) {
                     fprintf(stderr, "%s%s did not propagate unit clause ",
                         upderiver_error_header,
                         __func__);
                     fprintclause_nl(stderr, deriver, cls, READABLE, NO_HEADER);
-                    exit(EXIT_FAILURE);
+                    fail();
                 }
+            }
+        }
     }
 #endif
 
@@ -661,31 +815,58 @@ upderiver* upderiver_new (void)
     deriver->dlevel = 0;
 
     deriver->trail     = NULL;
-    deriver->assigns   = NULL;
+    deriver->vals      = NULL;
     deriver->reasons   = NULL;
     deriver->trail_lim = NULL;
 
     deriver->is_ivar  = NULL;
     deriver->is_ovar  = NULL;
     deriver->is_wvar  = NULL;
+    deriver->implied  = NULL;
     deriver->ivars = NULL;
     deriver->ovars = NULL;
     deriver->wvars = NULL;
-    deriver->names    = NULL;
+    deriver->wlits = NULL;
+    deriver->ovar_assumed = -1;
+    deriver->keep_names      = true;
+    deriver->name_arena      = NULL;
+    deriver->name_arena_size = 0;
+    deriver->name_arena_cap  = 0;
+    deriver->name_offs       = NULL;
+    deriver->name_table      = NULL;
+    deriver->name_table_cap  = 0;
+    deriver->nof_names       = 0;
 
     deriver->nof_ivars = 0;
     deriver->nof_ovars = 0;
     deriver->nof_wvars = 0;
 
+    deriver->minimize = false;
+    memset(&deriver->stats, 0, sizeof(upderiver_stats));
+
     deriver->buf      = NULL;
     deriver->buf_size = 0;
+    deriver->tmp_lits = NULL;
+    deriver->tmp_cap  = 0;
 
     deriver->nof_clauses = 0;
-    deriver->cap_clauses = 0;
-    deriver->clauses     = NULL;
+    deriver->arena_size  = 0;
+    deriver->arena_cap   = 0;
+    deriver->arena       = NULL;
+
+    deriver->occs_nof_clauses     = -1;
+    deriver->occs_size            = -1;
+    deriver->occs_begin           = NULL;
+    deriver->occs                 = NULL;
+    deriver->occs_max_clause_size = 0;
+    deriver->lanes        = NULL;
+    deriver->lanes_prefix = NULL;
+    deriver->lanes_queued = NULL;
+    deriver->lanes_queue  = NULL;
 
     deriver->wlists   = NULL;
 
+    deriver->dimacs       = false;
     deriver->lit_neg      = NULL;
     deriver->lit_sign     = NULL;
     deriver->lit_extvar   = NULL;
@@ -704,33 +885,37 @@ void upderiver_delete (upderiver *deriver)
     if (NULL != deriver->extvars){
         free(deriver->extvars);
         free(deriver->trail);
-        free(deriver->assigns);
+        free(deriver->vals);
         free(deriver->reasons);
         free(deriver->trail_lim);
         free(deriver->is_ivar);
         free(deriver->is_ovar);
         free(deriver->is_wvar);
+        free(deriver->implied);
         free(deriver->ivars);
         free(deriver->ovars);
         free(deriver->wvars);
+        free(deriver->wlits);
 
-        for (int i = 0; i < deriver->size; i++) {
-            char *p = deriver->names[i];
-            if (NULL != p) free(p);
-        }
-        free(deriver->names);
+        free(deriver->name_offs);
 
         free(deriver->buf);
+        for (int i = 0; i < 2*deriver->size; i++)
+            free(deriver->wlists[i].ws);
         free(deriver->wlists);
     }
 
-    if (NULL != deriver->clauses) {
-        clause *begin = deriver->clauses;
-        clause *end   = begin + deriver->nof_clauses;
-        for (clause *p = begin; p < end; p++) 
-            free(p->lits);
-        free(deriver->clauses);
-    }
+    free(deriver->tmp_lits);
+    free(deriver->arena);
+    free(deriver->name_arena);
+    free(deriver->name_table);
+
+    free(deriver->occs_begin);
+    free(deriver->occs);
+    free(deriver->lanes);
+    free(deriver->lanes_prefix);
+    free(deriver->lanes_queued);
+    free(deriver->lanes_queue);
 
     free(deriver);
 }
@@ -741,54 +926,64 @@ void upderiver_addfunc (upderiver *deriver,
     int (*lit_var)      (int lit),
     int (*toLit)        (int var))
 {
+    deriver->dimacs       = false;
     deriver->lit_neg      = lit_neg;
     deriver->lit_sign     = lit_sign;
     deriver->lit_extvar   = lit_var;
     deriver->extvar_toLit = toLit;
 }
 
+void upderiver_usedimacs (upderiver *deriver)
+{
+    deriver->dimacs       = true;
+    deriver->lit_neg      = NULL;
+    deriver->lit_sign     = NULL;
+    deriver->lit_extvar   = NULL;
+    deriver->extvar_toLit = NULL;
+}
+
+STATIC int compare_lits (const void *a, const void *b)
+{
+    const int x = *(const int*)a;
+    const int y = *(const int*)b;
+    return x < y? -1: (x > y? 1: 0);
+}
+
 int upderiver_addclause (upderiver *deriver, int *begin, int *end)
 {
-    if (0 != deriver->dlevel) {
-        fprintf(stderr, "%s%s was called in non-root level.\n",
-            upderiver_error_header,
-            __func__);
-        exit(EXIT_FAILURE);
-    }
+    // drop the levels kept from the last derivation.
+    canceluntil(deriver, 0);
     if (end-begin < 1) {
         fprintf(stderr, "%s%s received empty clause.\n", 
             upderiver_error_header,
             __func__);
-        exit(EXIT_FAILURE);
+        fail();
     }
-    for (int* i = begin; i < end; i++) {
-        int *min_j = i;
-        for (int *j = i+1; j < end; j++) {
-            min_j = deriver->lit_extvar(*j) < deriver->lit_extvar(*min_j) 
-                || (deriver->lit_extvar(*j) == deriver->lit_extvar(*min_j) 
-                    && lit_neg(deriver, *j))? j: min_j;
-        }
-        int tmp = *i;
-        *i      = *min_j;
-        *min_j  = tmp;
-    }
-    for (int* i = begin; i+1 < end; i++) {
-        int* new_end = i+1;
-        for (int* j = i+1; j < end; j++) {
-            if (lit_neg(deriver, *j) == *i) // tautology
-                return upderiver_tautology_was_added;
-            if (*i == *j) // duplicates
-                continue;
-            int tmp = *new_end;
-            *new_end = *j;
-            *j = tmp;
-            new_end++;
-        }
-        end = new_end;
+    if (deriver->tmp_cap < end-begin) {
+        while (deriver->tmp_cap < end-begin)
+            deriver->tmp_cap = deriver->tmp_cap*2+1;
+        deriver->tmp_lits = (int*)realloc(deriver->tmp_lits,
+            sizeof(int)*(size_t)deriver->tmp_cap);
     }
 
-    for (int* i = begin; i < end; i++)
-        import_extvar(deriver, deriver->lit_extvar(*i));
+    // convert to internal literals and sort them by variable.
+    int *lits = deriver->tmp_lits;
+    for (int* i = begin; i < end; i++) {
+        import_extvar(deriver, extlit_extvar(deriver, *i));
+        lits[i-begin] = extlit_toLit(deriver, *i);
+    }
+    end   = lits + (end-begin);
+    begin = lits;
+    qsort(begin, (size_t)(end-begin), sizeof(int), compare_lits);
+    int* new_end = begin+1;
+    for (int* i = begin+1; i < end; i++) {
+        if (lit_neg(deriver, *i) == new_end[-1]) // tautology
+            return upderiver_tautology_was_added;
+        if (*i == new_end[-1]) // duplicates
+            continue;
+        *new_end++ = *i;
+    }
+    end = new_end;
 
     assert (end-begin >= 1);
     if (end-begin == 1) {
@@ -796,12 +991,338 @@ int upderiver_addclause (upderiver *deriver, int *begin, int *end)
         return upderiver_unit_was_added;
     } else {
         const int cls = clause_import(deriver, begin, end);
-        wlist_push(deriver, cls, clause_watch(deriver,cls)[0]);
-        wlist_push(deriver, cls, clause_watch(deriver,cls)[1]);
+        wlist_push(deriver, lit_neg(deriver, begin[0]), cls, begin[1]);
+        wlist_push(deriver, lit_neg(deriver, begin[1]), cls, begin[0]);
         return cls;
     }
 }
 
+void upderiver_seterrorhook (void (*hook) (void))
+{
+    error_hook = hook;
+}
+
+void upderiver_setminimize (upderiver *deriver, bool minimize)
+{
+    deriver->minimize = minimize;
+}
+
+const upderiver_stats *upderiver_getstats (upderiver *deriver)
+{
+    return &deriver->stats;
+}
+
+STATIC const char *get_name (upderiver *deriver, int extvar)
+{
+    int intvar = deriver->intvars[extvar];
+    const int offset = deriver->name_offs[intvar];
+    return 0 <= offset? deriver->name_arena + offset: NULL;
+}
+
+// returns the name of var, or NULL if it has none.
+const char *upderiver_getname (upderiver *deriver, int var)
+{
+    if (var < 0 || var >= deriver->extsize || deriver->intvars[var] < 0)
+        return NULL;
+    return get_name(deriver, var);
+}
+
+int upderiver_getextsize (upderiver *deriver)
+{
+    return deriver->extsize;
+}
+
+void upderiver_setkeepnames (upderiver *deriver, bool keep)
+{
+    deriver->keep_names = keep;
+}
+
+STATIC void save_data (upderiver *deriver, FILE *out, const void *p, size_t n)
+{
+    (void)deriver;
+    if (n > 0 && fwrite(p, 1, n, out) != n) {
+        fprintf(stderr, "%sfailed to write snapshot.\n",
+            upderiver_error_header);
+        fail();
+    }
+}
+
+STATIC void load_data (upderiver *deriver,
+    const char **pos, const char *end, void *p, size_t n)
+{
+    (void)deriver;
+    if ((size_t)(end - *pos) < n) {
+        fprintf(stderr, "%sreceived truncated snapshot.\n",
+            upderiver_error_header);
+        fail();
+    }
+    if (0 < n)
+        memcpy(p, *pos, n);
+    *pos += n;
+}
+
+// writes variables, names, clauses and watch lists at the root level, in
+// the native byte order.
+void upderiver_save (upderiver *deriver, FILE *out)
+{
+    canceluntil(deriver, 0);
+    const int n = deriver->size;
+    const int header[] = {
+        deriver->extsize, n,
+        deriver->nof_ivars, deriver->nof_ovars, deriver->nof_wvars,
+        deriver->nof_clauses, deriver->arena_size,
+        deriver->qhead, deriver->qtail};
+    save_data(deriver, out, header, sizeof(header));
+    save_data(deriver, out, deriver->intvars, sizeof(int)*(size_t)deriver->extsize);
+    save_data(deriver, out, deriver->extvars, sizeof(int)*(size_t)n);
+    save_data(deriver, out, deriver->is_ivar, sizeof(bool)*(size_t)n);
+    save_data(deriver, out, deriver->is_ovar, sizeof(bool)*(size_t)n);
+    save_data(deriver, out, deriver->is_wvar, sizeof(bool)*(size_t)n);
+    save_data(deriver, out, deriver->ivars, sizeof(int)*(size_t)deriver->nof_ivars);
+    save_data(deriver, out, deriver->ovars, sizeof(int)*(size_t)deriver->nof_ovars);
+    save_data(deriver, out, deriver->wvars, sizeof(int)*(size_t)deriver->nof_wvars);
+    save_data(deriver, out, deriver->vals, sizeof(signed char)*2*(size_t)n);
+    save_data(deriver, out, deriver->reasons, sizeof(int)*(size_t)n);
+    save_data(deriver, out, deriver->trail, sizeof(int)*(size_t)deriver->qtail);
+    save_data(deriver, out, deriver->arena, sizeof(int)*(size_t)deriver->arena_size);
+    for (int lit = 0; lit < 2*n; lit++) {
+        wlist *wl = deriver->wlists + lit;
+        save_data(deriver, out, &wl->size, sizeof(int));
+        save_data(deriver, out, wl->ws, sizeof(watcher)*(size_t)wl->size);
+    }
+    save_data(deriver, out, &deriver->name_arena_size, sizeof(int));
+    save_data(deriver, out, deriver->name_arena,
+        sizeof(char)*(size_t)deriver->name_arena_size);
+    save_data(deriver, out, deriver->name_offs, sizeof(int)*(size_t)n);
+}
+
+STATIC void check_snapshot (upderiver *deriver, bool ok, const char func[])
+{
+    (void)deriver;
+    if (!ok) {
+        fprintf(stderr, "%s%s received malformed snapshot.\n",
+            upderiver_error_header,
+            func);
+        fail();
+    }
+}
+
+// checks that every index loaded from a snapshot is in range, so that a
+// corrupted snapshot is rejected instead of being followed.
+STATIC void check_loaded (upderiver *deriver, const char func[])
+{
+    const int n = deriver->size;
+    const int nof_lits = 2*n;
+    for (int extvar = 0; extvar < deriver->extsize; extvar++) {
+        const int intvar = deriver->intvars[extvar];
+        check_snapshot(deriver, -1 <= intvar && intvar < n
+            && (intvar < 0 || deriver->extvars[intvar] == extvar), func);
+    }
+    const unsigned char *tags[3] = {
+        (const unsigned char*)deriver->is_ivar,
+        (const unsigned char*)deriver->is_ovar,
+        (const unsigned char*)deriver->is_wvar};
+    int nof_tagged[3] = {0, 0, 0};
+    for (int intvar = 0; intvar < n; intvar++) {
+        const int extvar = deriver->extvars[intvar];
+        check_snapshot(deriver, 0 <= extvar && extvar < deriver->extsize
+            && deriver->intvars[extvar] == intvar, func);
+        int nof_tags = 0;
+        for (int k = 0; k < 3; k++) {
+            check_snapshot(deriver, tags[k][intvar] <= 1, func);
+            nof_tagged[k] += tags[k][intvar];
+            nof_tags += tags[k][intvar];
+        }
+        check_snapshot(deriver, nof_tags <= 1, func);
+        const int val = deriver->vals[2*intvar];
+        check_snapshot(deriver, (L_TRUE == val || L_FALSE == val || L_UNDEF == val)
+            && deriver->vals[2*intvar+1] == -val, func);
+    }
+    const int nof_vars[3] = {
+        deriver->nof_ivars, deriver->nof_ovars, deriver->nof_wvars};
+    const int *vars[3] = {deriver->ivars, deriver->ovars, deriver->wvars};
+    for (int k = 0; k < 3; k++) {
+        check_snapshot(deriver, nof_tagged[k] == nof_vars[k], func);
+        for (int i = 0; i < nof_vars[k]; i++)
+            check_snapshot(deriver, 0 <= vars[k][i] && vars[k][i] < n
+                && tags[k][vars[k][i]], func);
+    }
+    // the trail holds each assigned variable once.
+    int nof_assigned = 0;
+    for (int intvar = 0; intvar < n; intvar++)
+        nof_assigned += L_UNDEF != deriver->vals[2*intvar];
+    check_snapshot(deriver, nof_assigned == deriver->qtail, func);
+    for (int i = 0; i < deriver->qtail; i++) {
+        const int lit = deriver->trail[i];
+        check_snapshot(deriver, 0 <= lit && lit < nof_lits
+            && L_TRUE == deriver->vals[lit], func);
+    }
+
+    // watched[cls] is -1 for an offset that is not a clause, and otherwise
+    // has bit k set once lits[k] is watched.
+    int *watched = (int*)malloc(sizeof(int)*((size_t)deriver->arena_size+1));
+    int *seen = (int*)malloc(sizeof(int)*((size_t)n+1));
+    for (int i = 0; i < deriver->arena_size; i++)
+        watched[i] = -1;
+    for (int intvar = 0; intvar < n; intvar++)
+        seen[intvar] = -1;
+    int nof_clauses = 0;
+    bool ok = true;
+    for (int cls = 0; ok && cls < deriver->arena_size; ) {
+        const int size = deriver->arena[cls];
+        ok = 2 <= size && size < deriver->arena_size - cls;
+        // no variable occurs twice in a clause.
+        for (int i = cls+1; ok && i <= cls+size; i++) {
+            const int lit = deriver->arena[i];
+            ok = 0 <= lit && lit < nof_lits && seen[lit >> 1] != cls;
+            if (ok)
+                seen[lit >> 1] = cls;
+        }
+        if (ok) {
+            watched[cls] = 0;
+            nof_clauses++;
+            cls += size+1;
+        }
+    }
+    ok = ok && nof_clauses == deriver->nof_clauses;
+    for (int intvar = 0; ok && intvar < n; intvar++) {
+        const int cls = deriver->reasons[intvar];
+        ok = NO_REASON == cls
+            || (0 <= cls && cls < deriver->arena_size && 0 <= watched[cls]);
+    }
+    // a clause is watched once by the negation of each of its first two
+    // literals.
+    for (int lit = 0; ok && lit < nof_lits; lit++) {
+        const wlist *wl = deriver->wlists + lit;
+        for (int i = 0; ok && i < wl->size; i++) {
+            const int cls = wl->ws[i].cls;
+            ok = 0 <= cls && cls < deriver->arena_size && 0 <= watched[cls]
+                && 0 <= wl->ws[i].blocker && wl->ws[i].blocker < nof_lits;
+            if (!ok)
+                break;
+            const int k = deriver->arena[cls+1] == lit_neg(deriver, lit)? 1:
+                deriver->arena[cls+2] == lit_neg(deriver, lit)? 2: 0;
+            ok = 0 != k && 0 == (watched[cls] & k);
+            watched[cls] |= k;
+        }
+    }
+    for (int cls = 0; ok && cls < deriver->arena_size; cls++)
+        ok = -1 == watched[cls] || 3 == watched[cls];
+    // a false watched literal has its negation still to be propagated, or
+    // the other watched literal is true, as propagate() leaves them.
+    for (int intvar = 0; intvar < n; intvar++)
+        seen[intvar] = -1;
+    for (int i = 0; i < deriver->qtail; i++)
+        seen[deriver->trail[i] >> 1] = i;
+    for (int cls = 0; ok && cls < deriver->arena_size; cls++) {
+        if (-1 == watched[cls])
+            continue;
+        const int *lits = deriver->arena + cls + 1;
+        for (int k = 0; ok && k < 2; k++)
+            ok = !lit_is_falsified(deriver, lits[k])
+                || deriver->qhead <= seen[lits[k] >> 1]
+                || lit_is_satisfied(deriver, lits[1-k]);
+    }
+    free(watched);
+    free(seen);
+    check_snapshot(deriver, ok, func);
+}
+
+// restores a deriver saved by upderiver_save() from [begin, end) into a
+// deriver to which nothing has been added, and returns the end of the
+// saved data.
+const char *upderiver_load (upderiver *deriver,
+    const char *begin, const char *end)
+{
+    if (0 != deriver->extsize || 0 != deriver->nof_clauses) {
+        fprintf(stderr, "%s%s received non-empty deriver.\n",
+            upderiver_error_header,
+            __func__);
+        fail();
+    }
+    const char *pos = begin;
+    int header[9];
+    load_data(deriver, &pos, end, header, sizeof(header));
+    const int extsize = header[0];
+    const int n = header[1];
+    // each variable takes at least 25 bytes, so that the counts are checked
+    // against the data before anything is allocated.
+    const size_t left = (size_t)(end - pos);
+    check_snapshot(deriver, 0 <= extsize && 0 <= n && n <= extsize
+        && 0 <= header[2] && 0 <= header[3] && 0 <= header[4]
+        && (long long)header[2] + header[3] + header[4] <= n
+        && 0 <= header[5] && 0 <= header[6]
+        && 0 <= header[7] && header[7] <= header[8] && header[8] <= n
+        && sizeof(int)*(size_t)extsize <= left
+        && 25*(size_t)n + sizeof(int)*(size_t)header[6] <= left, __func__);
+
+    deriver->extsize = deriver->extcap = extsize;
+    deriver->intvars   = (int*)malloc(sizeof(int)*(size_t)extsize);
+    deriver->model_ext = (int*)malloc(sizeof(int)*(size_t)extsize);
+    for (int i = 0; i < extsize; i++)
+        deriver->model_ext[i] = L_UNDEF;
+    load_data(deriver, &pos, end, deriver->intvars, sizeof(int)*(size_t)extsize);
+    if (0 == n) {
+        for (int i = 0; i < extsize; i++)
+            check_snapshot(deriver, -1 == deriver->intvars[i], __func__);
+        return pos;
+    }
+
+    reserve_vars(deriver, n);
+    // freed by upderiver_delete() if loading fails.
+    for (int lit = 0; lit < 2*n; lit++)
+        deriver->wlists[lit].ws = NULL;
+    deriver->size        = n;
+    deriver->nof_ivars   = header[2];
+    deriver->nof_ovars   = header[3];
+    deriver->nof_wvars   = header[4];
+    deriver->nof_clauses = header[5];
+    deriver->arena_size  = deriver->arena_cap = header[6];
+    deriver->qhead       = header[7];
+    deriver->qtail       = header[8];
+    deriver->arena = (int*)malloc(sizeof(int)*(size_t)deriver->arena_cap);
+    load_data(deriver, &pos, end, deriver->extvars, sizeof(int)*(size_t)n);
+    load_data(deriver, &pos, end, deriver->is_ivar, sizeof(bool)*(size_t)n);
+    load_data(deriver, &pos, end, deriver->is_ovar, sizeof(bool)*(size_t)n);
+    load_data(deriver, &pos, end, deriver->is_wvar, sizeof(bool)*(size_t)n);
+    load_data(deriver, &pos, end, deriver->ivars, sizeof(int)*(size_t)deriver->nof_ivars);
+    load_data(deriver, &pos, end, deriver->ovars, sizeof(int)*(size_t)deriver->nof_ovars);
+    load_data(deriver, &pos, end, deriver->wvars, sizeof(int)*(size_t)deriver->nof_wvars);
+    load_data(deriver, &pos, end, deriver->vals, sizeof(signed char)*2*(size_t)n);
+    load_data(deriver, &pos, end, deriver->reasons, sizeof(int)*(size_t)n);
+    load_data(deriver, &pos, end, deriver->trail, sizeof(int)*(size_t)deriver->qtail);
+    load_data(deriver, &pos, end, deriver->arena, sizeof(int)*(size_t)deriver->arena_size);
+    for (int intvar = 0; intvar < n; intvar++)
+        deriver->implied[intvar] = false;
+    for (int lit = 0; lit < 2*n; lit++) {
+        wlist *wl = deriver->wlists + lit;
+        wl->size = wl->cap = 0;
+        int size;
+        load_data(deriver, &pos, end, &size, sizeof(int));
+        check_snapshot(deriver, 0 <= size
+            && sizeof(watcher)*(size_t)size <= (size_t)(end - pos), __func__);
+        wl->size = wl->cap = size;
+        if (0 < wl->size)
+            wl->ws = (watcher*)malloc(sizeof(watcher)*(size_t)wl->cap);
+        load_data(deriver, &pos, end, wl->ws, sizeof(watcher)*(size_t)wl->size);
+    }
+    int len;
+    load_data(deriver, &pos, end, &len, sizeof(int));
+    check_snapshot(deriver, 0 <= len && (size_t)len <= (size_t)(end - pos)
+        && (0 == len || '\0' == pos[len-1]), __func__);
+    deriver->name_arena_size = deriver->name_arena_cap = len;
+    deriver->name_arena = (char*)malloc(sizeof(char)*(size_t)len);
+    load_data(deriver, &pos, end, deriver->name_arena, (size_t)len);
+    load_data(deriver, &pos, end, deriver->name_offs, sizeof(int)*(size_t)n);
+    for (int intvar = 0; intvar < n; intvar++)
+        check_snapshot(deriver, -1 <= deriver->name_offs[intvar]
+            && deriver->name_offs[intvar] < len, __func__);
+    check_loaded(deriver, __func__);
+    for (int offset = 0; offset < len; offset += (int)strlen(deriver->name_arena+offset)+1)
+        name_table_insert(deriver, offset);
+    return pos;
+}
+
 STATIC void setivar (upderiver *deriver, int extvar)
 {
     assert(0 <= extvar);
@@ -812,7 +1333,7 @@ STATIC void setivar (upderiver *deriver, int extvar)
             upderiver_error_header,
             __func__,
             extvar);
-        exit(EXIT_FAILURE);
+        fail();
     }
 
     if (false == deriver->is_ivar[intvar])
@@ -830,7 +1351,7 @@ STATIC void setovar (upderiver *deriver, int extvar)
             upderiver_error_header,
             __func__,
             extvar);
-        exit(EXIT_FAILURE);
+        fail();
     }
 
     if (false == deriver->is_ovar[intvar])
@@ -848,7 +1369,7 @@ STATIC void setwvar (upderiver *deriver, int extvar)
             upderiver_error_header,
             __func__,
             extvar);
-        exit(EXIT_FAILURE);
+        fail();
     }
 
     if (false == deriver->is_wvar[intvar])
@@ -865,30 +1386,24 @@ STATIC void setname (upderiver *deriver,
         fprintf(stderr, "%s%s received empty string.\n",
             upderiver_error_header,
             __func__);
-        exit(EXIT_FAILURE);
+        fail();
     }
     if (name[n-1] != '\0') {
         fprintf(stderr, "%s%s received string missing null character.\n",
             upderiver_error_header,
             __func__);
-        exit(EXIT_FAILURE);
-    }
-    char *copy = (char*)malloc(sizeof(char)*(size_t)n);
-    int i = 0;
-    while (i < n) {
-        copy[i] = name[i];
-        i++;
+        fail();
     }
-    assert(copy[n-1] == '\0');
 
     const int intvar = import_extvar(deriver, extvar);
-    if (NULL == deriver->names[intvar])
-        deriver->names[intvar] = copy;
-    else {
+    if (!deriver->keep_names)
+        return;
+    if (0 <= deriver->name_offs[intvar]) {
         fprintf(stderr, "%svariable %d already has name.\n", 
             upderiver_warning_header, extvar);
-        free(copy);
+        return;
     }
+    deriver->name_offs[intvar] = intern_name(deriver, name, n);
 }
 
 void upderiver_setvar (upderiver *deriver,
@@ -905,70 +1420,407 @@ void upderiver_setvar (upderiver *deriver,
             upderiver_error_header,
             __func__
         );
-        exit(EXIT_FAILURE);
+        fail();
     }
     setname (deriver, name, maxlen, var);
 }
 
+STATIC int derive_for_ovar (upderiver *deriver, int extvar,
+    int *clause, int maxlen, int model[], int model_size)
+{
+    if (extvar < 0 || extvar >= deriver->extsize
+        || deriver->intvars[extvar] < 0
+        || !deriver->is_ovar[deriver->intvars[extvar]]) {
+        fprintf(stderr, "%s%s received %d, which is not an output variable.\n",
+            upderiver_error_header,
+            __func__,
+            extvar);
+        fail();
+    }
+
+    // the negated output variable is assumed at level 1 and the i-th
+    // witness variable at level i+2. the levels are kept after derivation,
+    // and the next derivation for the same output variable backtracks only
+    // to the first witness variable whose value has changed. the levels of
+    // only one output variable are kept, and a derivation for another one
+    // starts from the root level. the witness variables are not assumed
+    // below the negated output variable to share them, since each clause
+    // includes its output variable and nothing would be propagated before
+    // it is assumed, so no level could be reused after a witness change.
+    const int intvar = deriver->intvars[extvar];
+    assert(is_intvar(deriver, intvar));
+    int level = 0;
+    if (deriver->ovar_assumed == intvar && 0 < deriver->dlevel) {
+        level = 1;
+        while (level < deriver->dlevel) {
+            const int i = level-1;
+            const int wvar = deriver->wvars[i];
+            const int lit = model_int(deriver, model, model_size, wvar) == L_TRUE?
+                intvar_toLit(deriver, wvar):
+                lit_neg(deriver, intvar_toLit(deriver, wvar));
+            if (lit != deriver->wlits[i])
+                break;
+            level++;
+        }
+    }
+    canceluntil(deriver, level);
+
+    if (0 == level) {
+        assert(intvar_value(deriver, intvar) == L_UNDEF);
+        assume(deriver, lit_neg(deriver, intvar_toLit(deriver, intvar)));
+        propagate(deriver);
+        deriver->ovar_assumed = intvar;
+    }
+    for (int i = deriver->dlevel-1; i < deriver->nof_wvars; i++) {
+        const int intvar = deriver->wvars[i];
+        assert(deriver->is_wvar[intvar]);
+        deriver->wlits[i] =
+            model_int(deriver, model, model_size, intvar) == L_TRUE?
+            intvar_toLit(deriver, intvar):
+            lit_neg(deriver, intvar_toLit(deriver, intvar));
+        assume(deriver, deriver->wlits[i]);
+        propagate(deriver);
+    }
+    assert(deriver->dlevel == deriver->nof_wvars+1);
+    const int derived_clause_size = derive_clause(deriver, clause, maxlen);
+    assert(derived_clause_size <= maxlen);
+
+    /*
+    fprintf(stdout, "c derived(%d) ", derived_clause_size);
+    fprintlits_nl(stdout, deriver, 
+        clause, clause+derived_clause_size, READABLE, NO_HEADER);
+    */
+
+    return derived_clause_size;
+}
+
+STATIC void check_derive_args (upderiver *deriver, const char func[],
+    int derived_clause[], int falsified_ovars[], int nof_falsified_ovars)
+{
+    if (NULL == falsified_ovars || NULL == derived_clause) {
+        fprintf(stderr, "%s%s received null pointer.\n",
+            upderiver_error_header,
+            func);
+        fail();
+    }
+    if (nof_falsified_ovars <= 0) {
+        fprintf(stderr, "%s%s received no output variable.\n",
+            upderiver_error_header,
+            func);
+        fail();
+    }
+}
+
+// returns the index of the output variable whose negation is assumed at
+// level 1, or 0 if none of them is. deriving for it first reuses its levels.
+STATIC int assumed_ovar_index (upderiver *deriver,
+    int falsified_ovars[], int nof_falsified_ovars)
+{
+    if (0 == deriver->dlevel || deriver->ovar_assumed < 0)
+        return 0;
+    for (int i = 0; i < nof_falsified_ovars; i++) {
+        const int extvar = falsified_ovars[i];
+        if (0 <= extvar && extvar < deriver->extsize
+            && deriver->intvars[extvar] == deriver->ovar_assumed)
+            return i;
+    }
+    return 0;
+}
+
+// derives a clause for each falsified output variable and returns the
+// shortest one, the first one if several are, setting *min_i to the index
+// of its output variable. the output variable assumed last is derived for
+// first, and each other one cancels to the root level and propagates its
+// negation and all witness variables again.
 int  upderiver_derive (upderiver *deriver,
     int derived_clause[], int max_derived_clause_size, int *min_i,
     int falsified_ovars[], int nof_falsified_ovars,
     int model[],  int model_size)
 {
-    if (NULL == falsified_ovars || NULL == derived_clause) {
+    check_derive_args(deriver, __func__,
+        derived_clause, falsified_ovars, nof_falsified_ovars);
+
+    if (1 == nof_falsified_ovars) {
+        if (NULL != min_i)
+            *min_i = 0;
+        return derive_for_ovar(deriver, falsified_ovars[0],
+            derived_clause, max_derived_clause_size, model, model_size);
+    }
+
+    const int first =
+        assumed_ovar_index(deriver, falsified_ovars, nof_falsified_ovars);
+    int min_size = -1;
+    int min_index = -1;
+    for (int k = 0; k < nof_falsified_ovars; k++) {
+        const int i = (first + k) % nof_falsified_ovars;
+        const int size = derive_for_ovar(deriver, falsified_ovars[i],
+            deriver->buf, deriver->size, model, model_size);
+        if (0 <= min_size
+            && (min_size < size || (min_size == size && min_index < i)))
+            continue;
+        if (size > max_derived_clause_size) {
+            fprintf(stderr, "%s%s exceeds maximum length.\n",
+                upderiver_error_header,
+                __func__);
+            fail();
+        }
+        min_size = size;
+        min_index = i;
+        if (NULL != min_i)
+            *min_i = i;
+        memcpy(derived_clause, deriver->buf, sizeof(int)*(size_t)size);
+    }
+    return min_size;
+}
+
+// derives a clause for each falsified output variable, one after another
+// in derived_clauses. returns the total number of literals. as in
+// upderiver_derive(), the output variable assumed last is derived for
+// first, and each other one propagates its negation and all witness
+// variables again from the root level.
+int  upderiver_derive_all (upderiver *deriver,
+    int derived_clauses[], int max_total_size, int derived_sizes[],
+    int falsified_ovars[], int nof_falsified_ovars,
+    int model[],  int model_size)
+{
+    check_derive_args(deriver, __func__,
+        derived_clauses, falsified_ovars, nof_falsified_ovars);
+    if (NULL == derived_sizes) {
         fprintf(stderr, "%s%s received null pointer.\n",
             upderiver_error_header,
             __func__);
-        exit(EXIT_FAILURE);
+        fail();
     }
-    if (nof_falsified_ovars <= 0) {
-        fprintf(stderr, "%s%s received no output variable.\n",
+
+    const int first =
+        assumed_ovar_index(deriver, falsified_ovars, nof_falsified_ovars);
+    int first_size = 0;
+    if (0 < first)
+        first_size = derive_for_ovar(deriver, falsified_ovars[first],
+            deriver->buf, deriver->size, model, model_size);
+    int total = 0;
+    for (int i = 0; i < nof_falsified_ovars; i++) {
+        if (0 < first && i == first) {
+            if (first_size > max_total_size - total) {
+                fprintf(stderr, "%s%s exceeds maximum length.\n",
+                    upderiver_error_header,
+                    __func__);
+                fail();
+            }
+            memcpy(derived_clauses + total, deriver->buf,
+                sizeof(int)*(size_t)first_size);
+            derived_sizes[i] = first_size;
+        } else
+            derived_sizes[i] = derive_for_ovar(deriver, falsified_ovars[i],
+                derived_clauses + total, max_total_size - total,
+                model, model_size);
+        total += derived_sizes[i];
+    }
+    return total;
+}
+
+//=============================================================================
+
+STATIC void batch_build_occs (upderiver *deriver)
+{
+    const int nof_lits = 2*deriver->size;
+    deriver->occs_begin = (int*)realloc(deriver->occs_begin,
+        sizeof(int)*((size_t)nof_lits+1));
+    deriver->occs = (int*)realloc(deriver->occs,
+        sizeof(int)*((size_t)deriver->arena_size+1));
+    deriver->lanes = (uint64_t*)realloc(deriver->lanes,
+        sizeof(uint64_t)*((size_t)nof_lits+1));
+    deriver->lanes_queued = (bool*)realloc(deriver->lanes_queued,
+        sizeof(bool)*((size_t)nof_lits+1));
+    deriver->lanes_queue = (int*)realloc(deriver->lanes_queue,
+        sizeof(int)*((size_t)nof_lits+1));
+
+    // count occurrences of each literal, and then place clauses.
+    int max_size = 0;
+    for (int i = 0; i <= nof_lits; i++)
+        deriver->occs_begin[i] = 0;
+    for (int cls = 0; cls < deriver->arena_size;
+        cls += 1 + clause_size(deriver, cls)) {
+        const int *lits = clause_lits(deriver, cls);
+        const int size  = clause_size(deriver, cls);
+        max_size = size > max_size? size: max_size;
+        for (int i = 0; i < size; i++)
+            deriver->occs_begin[lits[i]+1]++;
+    }
+    for (int i = 0; i < nof_lits; i++)
+        deriver->occs_begin[i+1] += deriver->occs_begin[i];
+    int *pos = deriver->lanes_queue; // used as a temporary counter
+    for (int i = 0; i < nof_lits; i++)
+        pos[i] = deriver->occs_begin[i];
+    for (int cls = 0; cls < deriver->arena_size;
+        cls += 1 + clause_size(deriver, cls)) {
+        const int *lits = clause_lits(deriver, cls);
+        for (int i = 0; i < clause_size(deriver, cls); i++)
+            deriver->occs[pos[lits[i]]++] = cls;
+    }
+    for (int i = 0; i < nof_lits; i++)
+        deriver->lanes_queued[i] = false;
+
+    deriver->lanes_prefix = (uint64_t*)realloc(deriver->lanes_prefix,
+        sizeof(uint64_t)*((size_t)max_size+1));
+    deriver->occs_max_clause_size = max_size;
+    deriver->occs_nof_clauses     = deriver->nof_clauses;
+    deriver->occs_size            = deriver->size;
+}
+
+// sets lit true in lanes.
+STATIC inline void batch_assign (upderiver *deriver,
+    int lit, uint64_t lanes, int *qsize)
+{
+    const uint64_t added = lanes & ~deriver->lanes[lit];
+    if (0 == added)
+        return;
+    deriver->lanes[lit] |= added;
+    if (!deriver->lanes_queued[lit]) {
+        deriver->lanes_queued[lit] = true;
+        deriver->lanes_queue[(*qsize)++] = lit;
+    }
+}
+
+// unit propagation in all active lanes at once. returns the lanes in which
+// a clause got falsified.
+STATIC uint64_t batch_propagate (upderiver *deriver, uint64_t active, int qsize)
+{
+    uint64_t *lanes  = deriver->lanes;
+    uint64_t *prefix = deriver->lanes_prefix;
+    uint64_t conflict = 0;
+    while (qsize > 0) {
+        const int lit = deriver->lanes_queue[--qsize];
+        deriver->lanes_queued[lit] = false;
+        const int false_lit = lit_neg(deriver, lit);
+        const int *begin = deriver->occs + deriver->occs_begin[false_lit];
+        const int *end   = deriver->occs + deriver->occs_begin[false_lit+1];
+        for (const int *o = begin; o < end; o++) {
+            const int *lits = clause_lits(deriver, *o);
+            const int size  = clause_size(deriver, *o);
+            uint64_t satisfied = 0;
+            uint64_t falsified = active;
+            for (int i = 0; i < size; i++) {
+                prefix[i]  = falsified;
+                satisfied |= lanes[lits[i]];
+                falsified &= lanes[lit_neg(deriver, lits[i])];
+            }
+            conflict |= falsified & ~satisfied;
+            // a literal is implied in lanes where all the others are false.
+            uint64_t suffix = active;
+            for (int i = size-1; i >= 0; i--) {
+                const uint64_t neg = lanes[lit_neg(deriver, lits[i])];
+                const uint64_t unit = prefix[i] & suffix & ~satisfied & ~neg;
+                if (0 != unit)
+                    batch_assign(deriver, lits[i], unit, &qsize);
+                suffix &= neg;
+            }
+        }
+    }
+    return conflict;
+}
+
+// derives a clause for ovar and each of the models, one after another in
+// derived_clauses, by propagating up to upderiver_batch_lanes models at
+// once. derived_sizes[k] is -1 if propagation fails for the k-th model.
+// returns the total number of literals. the clauses are not minimised, so
+// the deriver must not be set to minimise.
+int  upderiver_derive_batch (upderiver *deriver,
+    int derived_clauses[], int max_total_size, int derived_sizes[],
+    int ovar, int *models[], int nof_models, int model_size)
+{
+    if (NULL == derived_clauses || NULL == derived_sizes || NULL == models) {
+        fprintf(stderr, "%s%s received null pointer.\n",
             upderiver_error_header,
             __func__);
-        exit(EXIT_FAILURE);
+        fail();
     }
-    if (nof_falsified_ovars > 1) {
-        fprintf(stderr,
-            "%s%s multiple output variables not supported in current version.\n",
+    if (ovar < 0 || ovar >= deriver->extsize
+        || deriver->intvars[ovar] < 0
+        || !deriver->is_ovar[deriver->intvars[ovar]]) {
+        fprintf(stderr, "%s%s received %d, which is not an output variable.\n",
             upderiver_error_header,
-            __func__);
-        exit(EXIT_FAILURE);
+            __func__,
+            ovar);
+        fail();
     }
-    if (deriver->dlevel != 0) {
-        fprintf(stderr, "%s%s must be called at root level.\n",
+    if (deriver->minimize) {
+        fprintf(stderr, "%s%s does not minimise derived clauses.\n",
             upderiver_error_header,
             __func__);
-        exit(EXIT_FAILURE);
+        fail();
     }
 
-    const int intvar = deriver->intvars[falsified_ovars[0]];
-    assert(deriver->is_ovar[intvar]);
-    assert(is_intvar(deriver, intvar));
-    assert(deriver->assigns[intvar] == L_UNDEF);
-    assume(deriver, lit_neg(deriver, intvar_toLit(deriver, intvar)));
-    propagate(deriver);
-    for (int i = 0; i < deriver->nof_wvars; i++) {
-        const int intvar = deriver->wvars[i];
-        assert(deriver->is_wvar[intvar]);
-        enqueue(deriver,
-            model_int(deriver, model, model_size, intvar) == L_TRUE?
-            intvar_toLit(deriver, intvar):
-            lit_neg(deriver, intvar_toLit(deriver, intvar)),
-            NO_REASON);
-        propagate(deriver);
-    }
-    const int derived_clause_size = 
-        derive_clause(deriver, &derived_clause[0], deriver->size);
-    assert(derived_clause_size <= deriver->size);
     canceluntil(deriver, 0);
-
-    /*
-    fprintf(stdout, "c derived(%d) ", derived_clause_size);
-    fprintlits_nl(stdout, deriver, 
-        derived_clause, derived_clause+derived_clause_size, READABLE, NO_HEADER);
-    */
-
-    return derived_clause_size;
+    if (deriver->occs_nof_clauses != deriver->nof_clauses
+        || deriver->occs_size != deriver->size)
+        batch_build_occs(deriver);
+
+    const int nof_lits = 2*deriver->size;
+    const int neg_ovar =
+        lit_neg(deriver, intvar_toLit(deriver, deriver->intvars[ovar]));
+    int total = 0;
+    for (int first = 0; first < nof_models; first += upderiver_batch_lanes) {
+        const int n = nof_models - first < upderiver_batch_lanes?
+            nof_models - first: upderiver_batch_lanes;
+        const uint64_t active = n < 64? (UINT64_C(1) << n) - 1: ~UINT64_C(0);
+        uint64_t conflict = 0;
+        int qsize = 0;
+
+        for (int i = 0; i < nof_lits; i++)
+            deriver->lanes[i] = 0;
+        for (int pos = 0; pos < deriver->qtail; pos++) // root level
+            batch_assign(deriver, deriver->trail[pos], active, &qsize);
+        batch_assign(deriver, neg_ovar, active, &qsize);
+        for (int k = 0; k < n; k++) {
+            const uint64_t lane = UINT64_C(1) << k;
+            for (int i = 0; i < deriver->nof_wvars; i++) {
+                const int intvar = deriver->wvars[i];
+                const int lit =
+                    model_int(deriver, models[first+k], model_size, intvar)
+                    == L_TRUE?
+                    intvar_toLit(deriver, intvar):
+                    lit_neg(deriver, intvar_toLit(deriver, intvar));
+                batch_assign(deriver, lit, lane, &qsize);
+            }
+        }
+        for (int i = 0; i < nof_lits; i += 2)
+            conflict |= deriver->lanes[i] & deriver->lanes[i+1];
+        conflict |= batch_propagate(deriver, active, qsize);
+
+        for (int k = 0; k < n; k++) {
+            const uint64_t lane = UINT64_C(1) << k;
+            if (conflict & lane) {
+                derived_sizes[first+k] = -1;
+                continue;
+            }
+            int count = 0;
+            for (int i = 0; i < deriver->nof_ivars; i++) {
+                const int intvar = deriver->ivars[i];
+                if (L_UNDEF != intvar_value(deriver, intvar)) // root level
+                    continue;
+                const int lit = intvar_toLit(deriver, intvar);
+                int derived_lit;
+                if (deriver->lanes[lit] & lane)
+                    derived_lit = lit_neg(deriver, lit);
+                else if (deriver->lanes[lit_neg(deriver, lit)] & lane)
+                    derived_lit = lit;
+                else
+                    continue;
+                if (!(total + count < max_total_size)) {
+                    fprintf(stderr, "%s%s exceeds maximum length.\n",
+                        upderiver_error_header,
+                        __func__);
+                    fail();
+                }
+                derived_clauses[total + count++] =
+                    lit_toExtlit(deriver, derived_lit);
+            }
+            derived_sizes[first+k] = count;
+            total += count;
+        }
+    }
+    return total;
 }
 
 //=============================================================================
@@ -983,8 +1835,8 @@ STATIC void fprintlit (FILE *out, upderiver *deriver, int lit, bool readable)
     }
 
     fprintf(out, "%s", lit_sign(deriver, lit)? "~":"");
-    if (NULL != deriver->names[intvar])
-        fprintf(out, "%s", deriver->names[intvar]);
+    if (0 <= deriver->name_offs[intvar])
+        fprintf(out, "%s", deriver->name_arena + deriver->name_offs[intvar]);
     else
         fprintf(out, "%d", extvar);
 }
@@ -1015,7 +1867,7 @@ STATIC void fprintassigns (FILE *out, upderiver *deriver,
         int intvar = lit_intvar(deriver, *i);
         fprintlit(out, deriver, intvar_toLit(deriver, intvar), readable);
         fprintf(out, "=");
-        fprintf(out, "%d", deriver->assigns[intvar]);
+        fprintf(out, "%d", intvar_value(deriver, intvar));
         if (i+1 < end)
             fprintf(out, " ");
     }
@@ -1037,8 +1889,7 @@ STATIC void fprintclause (FILE *out, upderiver *deriver,
     int *end   = begin + clause_size(deriver, cls);
     for (int* i = begin; i < end; i++) {
         fprintlit(out, deriver, *i, readable);
-        if (lit_neg(deriver, clause_watch(deriver, cls)[0]) == *i
-            || lit_neg(deriver, clause_watch(deriver, cls)[1]) == *i)
+        if (i < begin+2) // watched
             fprintf(out, "*");
         if (i+1 < end)
             fprintf(out, " ");
@@ -1078,11 +1929,9 @@ STATIC int track_propagation (FILE *out, upderiver *deriver,
                 upderiver_warning_header);
             return count;
         }
-        assert(lit_neg(deriver, lit) == clause_watch(deriver, cls)[0]
-            || lit_neg(deriver, lit) == clause_watch(deriver, cls)[1]);
-        *(sources+count) = lit_neg(deriver, lit) == clause_watch(deriver, cls)[0]?
-                            clause_watch(deriver, cls)[1]:
-                            clause_watch(deriver, cls)[0];
+        // a reason clause keeps the propagated literal as first watch.
+        assert(lit == clause_lits(deriver, cls)[0]);
+        *(sources+count) = lit_neg(deriver, clause_lits(deriver, cls)[1]);
         *(targets+count) = lit;
         count++;
     }
@@ -1126,34 +1975,16 @@ STATIC bool is_intvar (upderiver *deriver, int intvar)
 
 STATIC bool is_clause (upderiver *deriver, int cls)
 {
-    return 0 <= cls && cls < deriver->nof_clauses;
+    return 0 <= cls && cls < deriver->arena_size
+        && cls + 1 + deriver->arena[cls] <= deriver->arena_size;
 }
 
 STATIC bool clause_is_watched_by (upderiver *deriver, int cls, int lit)
 {
     assert(is_clause(deriver, cls));
     const int false_lit = lit_neg(deriver, lit);
-    bool found = false;
-    int *begin = clause_lits(deriver, cls);
-    int *end   = begin + clause_size(deriver, cls);
-    for (int *i = begin; i < end; i++) {
-        if (false_lit == *i)
-            found = true;
-    }
-    if (!found)
-        return false;
-
-    for (int i = 0; i < 2; i++)
-        if (lit == clause_watch(deriver, cls)[i])
-            return true;
-    return false;
-}
-
-STATIC bool clause_is_sentinel (upderiver *deriver, int cls)
-{
-    assert(is_clause(deriver, cls));
-    int lit = clause_watch(deriver, cls)[0];
-    return wlist_sentinel(deriver, lit) == cls;
+    const int *lits = clause_lits(deriver, cls);
+    return false_lit == lits[0] || false_lit == lits[1];
 }
 
 STATIC void print_not_watched_error (upderiver *deriver, int cls, int lit)
@@ -1182,7 +2013,7 @@ STATIC bool clause_is_unit (upderiver *deriver, int cls)
             nof_true++;
         if (lit_is_falsified(deriver, *i))
             nof_false++;
-        if (L_UNDEF == deriver->assigns[lit_intvar(deriver, *i)])
+        if (L_UNDEF == intvar_value(deriver, lit_intvar(deriver, *i)))
             nof_undef++;
     }
     assert(nof_true + nof_false + nof_undef == clause_size(deriver, cls));
@@ -1234,10 +2065,4 @@ STATIC bool upderiver_is_ovar (upderiver *deriver, int extvar)
     return deriver->is_ovar[intvar];
 }
 
-STATIC const char *get_name (upderiver *deriver, int extvar)
-{
-    int intvar = deriver->intvars[extvar];
-    return deriver->names[intvar];
-}
-
 #endif
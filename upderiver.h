@@ -4,6 +4,7 @@
 extern "C" {
 #endif
 
+#include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
 #include <assert.h>
@@ -22,6 +23,17 @@ typedef enum {
     CECD_WVAR,
 } upderiver_var_tag;
 
+// statistics of derived clauses and propagation.
+typedef struct {
+    int       derived; // literals derived by the last call, before minimisation
+    int       removed; // literals removed by minimisation in the last call
+    long long total_derived;
+    long long total_removed;
+    long long nof_derive_calls;
+    long long propagations;  // literals propagated by propagate()
+    long long watch_visits;  // watchers visited by propagate()
+} upderiver_stats;
+
 extern upderiver* upderiver_new (void);
 extern void upderiver_delete (upderiver *deriver);
 extern void upderiver_addfunc (upderiver *deriver,
@@ -29,6 +41,7 @@ extern void upderiver_addfunc (upderiver *deriver,
     int (*lit_sign) (int lit),
     int (*lit_var)  (int lit),
     int (*toLit)    (int var));
+extern void upderiver_usedimacs (upderiver *deriver);
 extern int  upderiver_addclause (upderiver *deriver, int *begin, int *end);
 extern void upderiver_setvar (upderiver *deriver,
     int var, upderiver_var_tag tag, char* name, int maxlen);
@@ -37,7 +50,31 @@ extern int  upderiver_derive (upderiver *deriver,
     int *min_i,
     int falsified_ovars[],  int nof_falsified_ovars,
     int model[],  int model_size);
+// the deriver keeps the levels of the output variable derived for last, so
+// deriving for several output variables propagates from the root level for
+// each but the first one.
+extern int  upderiver_derive_all (upderiver *deriver,
+    int derived_clauses[], int max_total_size, int derived_sizes[],
+    int falsified_ovars[],  int nof_falsified_ovars,
+    int model[],  int model_size);
+extern int  upderiver_derive_batch (upderiver *deriver,
+    int derived_clauses[], int max_total_size, int derived_sizes[],
+    int ovar, int *models[], int nof_models, int model_size);
+extern void upderiver_setminimize (upderiver *deriver, bool minimize);
+// calls hook on errors, after printing the message to stderr, and exits
+// only if it returns. the hook is shared by all derivers and may throw an
+// exception when compiled as C++, after which the deriver must not be used.
+extern void upderiver_seterrorhook (void (*hook) (void));
+extern const upderiver_stats *upderiver_getstats (upderiver *deriver);
+extern const char *upderiver_getname (upderiver *deriver, int var);
+// one more than the largest variable known to the deriver.
+extern int  upderiver_getextsize (upderiver *deriver);
+extern void upderiver_setkeepnames (upderiver *deriver, bool keep);
+extern void upderiver_save (upderiver *deriver, FILE *out);
+extern const char *upderiver_load (upderiver *deriver,
+    const char *begin, const char *end);
 
+static const int upderiver_batch_lanes         = 64;
 static const int upderiver_tautology_was_added = -2;
 static const int upderiver_unit_was_added      = -1;
 
@@ -0,0 +1,110 @@
+#include "writer.hpp"
+
+namespace Albatross {
+
+
+Writer::Writer (FILE* f)
+        : file (f), async (false), stop (false)
+{
+    buf.reserve(capacity);
+}
+
+Writer::~Writer ()
+{
+    flush();
+    if (async) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        cond.notify_one();
+        thread.join();
+    }
+    fflush(file);
+}
+
+// hands full buffers to a thread writing them in order.
+void Writer::start_thread (void)
+{
+    if (async)
+        return;
+    flush();
+    async = true;
+    thread = std::thread(&Writer::run, this);
+}
+
+void Writer::run (void)
+{
+    std::vector<std::vector<char> > bufs;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [this] {return stop || !pending.empty();});
+            if (pending.empty())
+                return;
+            bufs.swap(pending);
+        }
+        for (auto i = bufs.begin(); i != bufs.end(); i++)
+            fwrite(i->data(), 1, i->size(), file);
+        fflush(file);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto i = bufs.begin(); i != bufs.end(); i++) {
+                i->clear();
+                spare.push_back(std::vector<char>());
+                spare.back().swap(*i);
+            }
+        }
+        drained.notify_one();
+        bufs.clear();
+    }
+}
+
+void Writer::flush (void)
+{
+    if (buf.empty())
+        return;
+    if (!async) {
+        fwrite(buf.data(), 1, buf.size(), file);
+        fflush(file);
+        buf.clear();
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        drained.wait(lock, [this] {return pending.size() < max_pending;});
+        pending.push_back(std::vector<char>());
+        pending.back().swap(buf);
+        if (!spare.empty()) {
+            buf.swap(spare.back());
+            spare.pop_back();
+        }
+    }
+    cond.notify_one();
+    buf.reserve(capacity);
+}
+
+Writer& Writer::operator<< (long long x)
+{
+    char digits[24];
+    char* p = digits + sizeof(digits);
+    unsigned long long u = x < 0? 0ULL - (unsigned long long)x: x;
+    do {
+        *--p = '0' + u%10;
+        u /= 10;
+    } while (u != 0);
+    if (x < 0)
+        *--p = '-';
+    put(p, digits + sizeof(digits) - p);
+    return *this;
+}
+
+Writer& Writer::operator<< (double x)
+{
+    char s[32];
+    int n = snprintf(s, sizeof(s), "%g", x);
+    put(s, n);
+    return *this;
+}
+
+}
@@ -0,0 +1,71 @@
+#ifndef albatross_writer_h
+#define albatross_writer_h
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Albatross {
+
+// collects output in a buffer that is written out when it is full or on
+// flush(), either directly or by a background thread if started, so that
+// nothing is flushed per line. flush() blocks while the thread has
+// max_pending buffers left to write.
+class Writer {
+    FILE* file;
+    std::vector<char> buf;
+    std::vector<std::vector<char> > pending; // buffers for the thread
+    std::vector<std::vector<char> > spare;   // written, to be reused
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::condition_variable drained;
+    bool async;
+    bool stop;
+
+    void run (void);
+
+    void put (const char* s, size_t n) {
+        buf.insert(buf.end(), s, s+n);
+        if (buf.size() >= capacity)
+            flush();
+    }
+
+public:
+    static const size_t capacity = 1 << 16;
+    static const size_t max_pending = 4;
+
+    Writer (FILE* f);
+    ~Writer ();
+
+    void start_thread (void);
+    void flush (void);
+
+    Writer& operator<< (char c) {
+        buf.push_back(c);
+        if (buf.size() >= capacity)
+            flush();
+        return *this;
+    }
+    Writer& operator<< (const char* s) {
+        put(s, strlen(s));
+        return *this;
+    }
+    Writer& operator<< (const std::string& s) {
+        put(s.data(), s.size());
+        return *this;
+    }
+    Writer& operator<< (long long x);
+    Writer& operator<< (int x) {
+        return *this << (long long)x;
+    }
+    Writer& operator<< (double x);
+};
+
+}
+
+#endif